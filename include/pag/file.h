@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <mutex>
+#include <type_traits>
 #include "pag/types.h"
 
 #ifdef PAG_USE_RTTR
@@ -287,6 +289,7 @@ class RTTR_AUTO_REGISTER_CLASS AnimatableProperty : public Property<T> {
   }
 
   ~AnimatableProperty() override {
+    delete bakedValues.load();
     for (auto& keyframe : keyframes) {
       delete keyframe;
     }
@@ -312,27 +315,54 @@ class RTTR_AUTO_REGISTER_CLASS AnimatableProperty : public Property<T> {
   }
 
   T getValueAt(Frame frame) override {
+    if (bakingEnabled) {
+      auto values = getBakedValues();
+      if (values != nullptr) {
+        auto index = std::max(frame - keyframes.front()->startTime, static_cast<Frame>(0));
+        return (*values)[std::min(static_cast<size_t>(index), values->size() - 1)];
+      }
+    }
+    return lookupValueAt(frame);
+  }
+
+  /**
+   * Sets whether the values of all frames are computed on the first access and then read from a
+   * table. It makes the random access of the property O(1), which speeds up the animations played
+   * repeatedly or scrubbed back and forth, at the cost of memory. Only the properties of plain
+   * values, such as numbers, points and colors, can be baked. The default value is false.
+   */
+  void setBakingEnabled(bool enabled) {
+    // The values that own memory, such as paths and text documents, would take a full copy per
+    // frame.
+    bakingEnabled = enabled && std::is_trivially_copyable<T>::value;
+  }
+
+  /**
+   * The keyframe list in this property.
+   */
+  std::vector<Keyframe<T>*> keyframes;
+
+ private:
+  // The properties whose table would take more memory than this are never baked.
+  static constexpr size_t MaxBakedBytes = 131072;  // 128K
+
+  std::atomic_size_t lastKeyframeIndex;
+  std::atomic_bool bakingEnabled = {false};
+  std::atomic<std::vector<T>*> bakedValues = {nullptr};
+
+  T lookupValueAt(Frame frame) {
     T result;
     size_t lastKeyframeIndexInternal = lastKeyframeIndex;
     Keyframe<T>* lastKeyframe = keyframes[lastKeyframeIndexInternal];
     if (lastKeyframe->containsTime(frame)) {
       return lastKeyframe->getValueAt(frame);
     }
-    if (frame < lastKeyframe->startTime) {
-      while (lastKeyframeIndexInternal > 0) {
-        lastKeyframeIndexInternal--;
-        if (keyframes[lastKeyframeIndexInternal]->containsTime(frame)) {
-          break;
-        }
-      }
-    } else {
-      while (lastKeyframeIndexInternal < keyframes.size() - 1) {
-        lastKeyframeIndexInternal++;
-        if (keyframes[lastKeyframeIndexInternal]->containsTime(frame)) {
-          break;
-        }
-      }
-    }
+    // The keyframes are sorted and contiguous, find the last one that starts before the frame.
+    auto iter = std::upper_bound(
+        keyframes.begin(), keyframes.end(), frame,
+        [](Frame time, const Keyframe<T>* keyframe) { return time < keyframe->startTime; });
+    lastKeyframeIndexInternal =
+        iter == keyframes.begin() ? 0 : static_cast<size_t>(iter - keyframes.begin() - 1);
     lastKeyframe = keyframes[lastKeyframeIndexInternal];
     if (frame <= lastKeyframe->startTime) {
       result = lastKeyframe->startValue;
@@ -345,13 +375,30 @@ class RTTR_AUTO_REGISTER_CLASS AnimatableProperty : public Property<T> {
     return result;
   }
 
-  /**
-   * The keyframe list in this property.
-   */
-  std::vector<Keyframe<T>*> keyframes;
-
- private:
-  std::atomic_size_t lastKeyframeIndex;
+  std::vector<T>* getBakedValues() {
+    auto values = bakedValues.load(std::memory_order_acquire);
+    if (values != nullptr) {
+      return values;
+    }
+    auto startTime = keyframes.front()->startTime;
+    auto frameCount = keyframes.back()->endTime - startTime + 1;
+    if (frameCount <= 0 || static_cast<size_t>(frameCount) > MaxBakedBytes / sizeof(T)) {
+      bakingEnabled = false;
+      return nullptr;
+    }
+    values = new std::vector<T>();
+    values->reserve(static_cast<size_t>(frameCount));
+    for (Frame i = 0; i < frameCount; i++) {
+      values->push_back(lookupValueAt(startTime + i));
+    }
+    std::vector<T>* expected = nullptr;
+    if (!bakedValues.compare_exchange_strong(expected, values, std::memory_order_acq_rel)) {
+      // Another thread has baked the values first.
+      delete values;
+      values = expected;
+    }
+    return values;
+  }
 
   RTTR_ENABLE(Property<T>)
 };
@@ -1816,6 +1863,7 @@ class PAG_API Layer {
   CachePolicy cachePolicy = CachePolicy::Auto;
 
   Cache* RTTR_SKIP_REGISTER_PROPERTY cache = nullptr;
+  Cache* RTTR_SKIP_REGISTER_PROPERTY transformCache = nullptr;
   std::mutex locker = {};
 
   virtual void excludeVaryingRanges(std::vector<TimeRange>* timeRanges);
@@ -2206,6 +2254,43 @@ class PAG_API Sequence {
 
   Frame toSequenceFrame(Frame compositionFrame);
 
+  /**
+   * Decodes the frames of this sequence if they were deferred by lazy decoding, does nothing if the
+   * frames are already decoded. This method is thread-safe.
+   */
+  void decodeDeferredFrames();
+
+  /**
+   * Returns true if the frames of this sequence are deferred by lazy decoding and not decoded yet.
+   */
+  bool hasDeferredFrames() const;
+
+  /**
+   * Defers decoding the frames of this sequence to the specified decoder, which is called once on
+   * the first call to decodeDeferredFrames().
+   */
+  void setDeferredFramesDecoder(std::function<void()> decoder);
+
+ private:
+  struct DeferredFrames {
+    DeferredFrames() = default;
+
+    // The decoder belongs to the original sequence, so copies start with no deferred frames.
+    DeferredFrames(const DeferredFrames&) {
+    }
+
+    DeferredFrames& operator=(const DeferredFrames&) {
+      return *this;
+    }
+
+    std::function<void()> decoder = nullptr;
+    // Checked without locking on the hot paths, the locker is only taken to decode the frames.
+    std::atomic_bool deferred = false;
+    std::mutex locker = {};
+  };
+
+  DeferredFrames deferredFrames = {};
+
   RTTR_ENABLE()
 };
 
@@ -2234,12 +2319,21 @@ class PAG_API BitmapSequence : public Sequence {
 
   virtual bool isEmptyBitmapFrame(size_t frameIndex);
 
+  /**
+   * Records which frames are empty while their bitmaps are deferred by lazy decoding, so that
+   * isEmptyBitmapFrame() answers without decoding them.
+   */
+  void setDeferredEmptyFrames(std::vector<bool> emptyFrames);
+
   Frame duration() const override {
     return static_cast<Frame>(frames.size());
   }
 
   bool verify() const override;
 
+ private:
+  std::vector<bool> deferredEmptyFrames = {};
+
   RTTR_ENABLE(Sequence)
 };
 
@@ -2409,6 +2503,50 @@ class PAG_API File {
    * file.
    */
   static std::shared_ptr<File> Load(const std::string& filePath);
+  /**
+   * Load a pag file from path by memory-mapping it. The embedded image, bitmap sequence and audio
+   * payloads reference the mapped pages directly instead of being copied to the heap, and the
+   * returned file keeps the mapping alive. Returns null if the file does not exist or the data is
+   * not a pag file.
+   */
+  static std::shared_ptr<File> LoadMapped(const std::string& filePath);
+  /**
+   * Sets whether the bitmap and video sequences of the pag files loaded afterwards are decoded
+   * lazily. If enabled, only the offsets of the sequence frames are recorded while loading, and the
+   * frames are decoded on their first access. The embedded images and audio reference the loaded
+   * bytes without copying. The default value is false.
+   */
+  static void SetLazyDecodingEnabled(bool enabled);
+
+  /**
+   * Returns true if the pag files are decoded lazily.
+   */
+  static bool LazyDecodingEnabled();
+
+  /**
+   * Sets whether the compositions of the pag files loaded afterwards are decoded concurrently on
+   * multiple threads. It speeds up loading the files with many compositions. The default value is
+   * false.
+   */
+  static void SetParallelDecodingEnabled(bool enabled);
+
+  /**
+   * Returns true if the compositions of the pag files are decoded concurrently.
+   */
+  static bool ParallelDecodingEnabled();
+
+  /**
+   * Sets whether the animatable properties of the pag files loaded afterwards bake the values of
+   * all frames into a table on their first access. It makes the random access of the keyframes
+   * O(1), which suits the templates played in loops or scrubbed back and forth, at the cost of
+   * memory. The default value is false.
+   */
+  static void SetKeyframeBakingEnabled(bool enabled);
+
+  /**
+   * Returns true if the animatable properties of the pag files bake their values.
+   */
+  static bool KeyframeBakingEnabled();
 
   ~File();
 
@@ -2528,6 +2666,8 @@ class PAG_API File {
   uint16_t _tagLevel = 1;
   int _numLayers = 0;
   bool encrypted = false;
+  // The source bytes referenced by the embedded payloads, only set when loaded without copying.
+  ByteData* sourceBytes = nullptr;
 
   // Just references, no need to delete them.
   std::vector<TextLayer*> textLayers = {};
@@ -2548,6 +2688,20 @@ class PAG_API File {
  */
 int64_t PAG_API CalculateGraphicsMemory(std::shared_ptr<File> file);
 
+/**
+ * Defines the compression algorithms of the pag file body.
+ */
+enum class BodyCompression {
+  /**
+   * The body is stored uncompressed, it can be read by all versions of SDK.
+   */
+  None,
+  /**
+   * The body is compressed in the raw LZ4 block format.
+   */
+  LZ4
+};
+
 class CodecContext;
 
 class PAG_API Codec {
@@ -2585,6 +2739,15 @@ class PAG_API Codec {
   static std::shared_ptr<File> Decode(const void* bytes, uint32_t byteLength,
                                       const std::string& path);
 
+  /**
+   * Decode a pag file from the specified byte data without copying the embedded payloads. The
+   * returned file takes ownership of the byte data and keeps it alive until the file is released.
+   * If lazyDecoding is true, the frames of bitmap and video sequences are decoded on their first
+   * access. Return null if the bytes is empty or it's not a valid pag file.
+   */
+  static std::shared_ptr<File> Decode(std::unique_ptr<ByteData> byteData, const std::string& path,
+                                      bool lazyDecoding = false);
+
   /**
    * Encode a pag file to byte data, return null if the file is null.
    */
@@ -2592,10 +2755,12 @@ class PAG_API Codec {
 
   /**
    * Encode a pag file with the corresponding performance data to byte data, return null if the file
-   * is null.
+   * is null. The body is compressed by the specified algorithm, and stored uncompressed if it can
+   * not be compressed smaller.
    */
   static std::unique_ptr<ByteData> Encode(std::shared_ptr<File> pagFile,
-                                          std::shared_ptr<PerformanceData> performanceData);
+                                          std::shared_ptr<PerformanceData> performanceData,
+                                          BodyCompression compression = BodyCompression::None);
 
   /**
    * Read the performance data from the specified byte data, return null if the byte data contains
@@ -2605,6 +2770,9 @@ class PAG_API Codec {
                                                               uint32_t byteLength);
 
  protected:
+  static std::shared_ptr<File> Decode(CodecContext* context, const void* bytes,
+                                      uint32_t byteLength, const std::string& path);
+
   static void UpdateFileAttributes(std::shared_ptr<File> file, CodecContext* context,
                                    const std::string& filePath);
 };
@@ -1223,6 +1223,49 @@ class PAG_API PAGFile : public PAGComposition {
    * file.
    */
   static std::shared_ptr<PAGFile> Load(const std::string& filePath);
+  /**
+   * Load a pag file from path by memory-mapping it. The embedded images, bitmap sequences and
+   * audio reference the mapped pages directly instead of being copied, so processes loading the
+   * same file share one resident copy. Returns null if the file does not exist or the data is not
+   * a pag file.
+   */
+  static std::shared_ptr<PAGFile> LoadMapped(const std::string& filePath);
+
+  /**
+   * Sets whether the bitmap and video sequences of the pag files loaded afterwards are decoded
+   * lazily on their first access instead of while loading, which reduces the time to the first
+   * frame of large files. The default value is false.
+   */
+  static void SetLazyDecodingEnabled(bool enabled);
+
+  /**
+   * Returns true if the pag files are decoded lazily.
+   */
+  static bool LazyDecodingEnabled();
+
+  /**
+   * Sets whether the compositions of the pag files loaded afterwards are decoded concurrently on
+   * multiple threads. The default value is false.
+   */
+  static void SetParallelDecodingEnabled(bool enabled);
+
+  /**
+   * Returns true if the compositions of the pag files are decoded concurrently.
+   */
+  static bool ParallelDecodingEnabled();
+
+  /**
+   * Sets whether the keyframes of the pag files loaded afterwards are baked into a table of values
+   * for every frame on their first access. It makes seeking to any frame cheap, which suits the
+   * templates played in loops or scrubbed back and forth, at the cost of memory. The default value
+   * is false.
+   */
+  static void SetKeyframeBakingEnabled(bool enabled);
+
+  /**
+   * Returns true if the keyframes of the pag files are baked.
+   */
+  static bool KeyframeBakingEnabled();
 
   PAGFile(std::shared_ptr<File> file, PreComposeLayer* layer);
 
@@ -1537,6 +1580,68 @@ class PAG_API PAGPlayer {
    */
   void setUseDiskCache(bool value);
 
+  /**
+   * The maximum number of frames that each video or bitmap sequence composition decodes ahead of
+   * the current frame on a background thread. Larger values help avoid stutters caused by slow
+   * frames, at the cost of more memory. The frames are prefetched in the current playing direction.
+   * The default value is 1.
+   */
+  int maxPrefetchFrames();
+
+  /**
+   * Set the value of maxPrefetchFrames property.
+   */
+  void setMaxPrefetchFrames(int value);
+
+  /**
+   * The maximum memory in bytes that the prefetched frames of each video or bitmap sequence
+   * composition can use, which may reduce the number of prefetched frames for large sequences. At
+   * least one frame is always prefetched. 0 means no limit. The default value is 0.
+   */
+  size_t prefetchMemoryLimit();
+
+  /**
+   * Set the value of prefetchMemoryLimit property.
+   */
+  void setPrefetchMemoryLimit(size_t value);
+
+  /**
+   * The maximum time in microseconds ahead of the current position that the video and bitmap
+   * sequence compositions start decoding. The sequences that have not been decoded before start at
+   * the beginning of the window. The others start as late as their measured decoding time and the
+   * current playback rate allow, which saves memory for the light ones. The default value is
+   * 500000.
+   */
+  int64_t prefetchWindow();
+
+  /**
+   * Set the value of prefetchWindow property.
+   */
+  void setPrefetchWindow(int64_t value);
+
+  /**
+   * The maximum number of video or bitmap sequence compositions that decode ahead at the same time.
+   * The nearest ones start first. 0 means no limit. The default value is 0.
+   */
+  int maxConcurrentPrefetches();
+
+  /**
+   * Set the value of maxConcurrentPrefetches property.
+   */
+  void setMaxConcurrentPrefetches(int value);
+
+  /**
+   * If set to true, PAGPlayer builds the transforms, masks and contents of the visible vector
+   * layers on multiple threads before drawing each frame. Turn it off to keep the rendering on the
+   * calling thread, which produces the same result. The default value is true.
+   */
+  bool parallelPrepareEnabled();
+
+  /**
+   * Set the value of parallelPrepareEnabled property.
+   */
+  void setParallelPrepareEnabled(bool value);
+
   /**
    * This value defines the scale factor for internal graphics caches, ranges from 0.0 to 1.0. The
    * scale factors less than 1.0 may result in blurred output, but it can reduce the usage of
@@ -1816,6 +1921,23 @@ class PAG_API PAGDecoder {
    */
   bool readFrame(int index, HardwareBufferRef hardwareBuffer);
 
+  /**
+   * Reads the image frames in the range [startIndex, endIndex) and passes their pixels to the
+   * callback along with the frame index. The range is split into consecutive shards which are
+   * rendered concurrently, each by its own offscreen reader and its own copy of the PAGFile, and all
+   * of them share the same disk cache. The frames are only read in parallel if the associated
+   * composition is an unmodified PAGFile. Otherwise, they are read one by one on the calling thread.
+   * The callback may be called from multiple threads at the same time in any order, and the pixels
+   * passed to it are only valid until it returns. Every thread holds an offscreen surface and a copy
+   * of the composition, pass a smaller maxThreads to limit the memory usage. Pass 0 to maxThreads to
+   * use one thread per hardware thread of the device. Returns false if any frame in the range failed
+   * to read.
+   */
+  bool readFrames(int startIndex, int endIndex,
+                  const std::function<void(int index, const void* pixels, size_t rowBytes)>& callback,
+                  ColorType colorType = ColorType::RGBA_8888,
+                  AlphaType alphaType = AlphaType::Premultiplied, int maxThreads = 0);
+
  private:
   std::mutex locker = {};
   int _width = 0;
@@ -1843,6 +1965,7 @@ class PAG_API PAGDecoder {
              float frameRate, float maxFrameRate);
 
   bool readFrameInternal(int index, std::shared_ptr<BitmapBuffer> bitmap);
+  void checkSequenceComplete(const std::shared_ptr<PAGComposition>& composition);
   bool renderFrame(std::shared_ptr<PAGComposition> composition, int index,
                    std::shared_ptr<BitmapBuffer> bitmap);
   bool checkSequenceFile(std::shared_ptr<PAGComposition> composition, const tgfx::ImageInfo& info);
@@ -1871,6 +1994,34 @@ class PAG_API PAGDiskCache {
    */
   static void SetMaxDiskSize(size_t size);
 
+  /**
+   * Returns true if the image frames in the disk cache are compressed. The default value is true.
+   */
+  static bool CompressionEnabled();
+
+  /**
+   * Sets whether the image frames in the disk cache are compressed. Uncompressed frames take much
+   * more disk space, but they can be accessed directly from the memory-mapped cache file without
+   * any decompression once all frames are cached. The setting only affects the cache files created
+   * afterward, the existing cache files that do not match it will be rebuilt when they are opened.
+   */
+  static void SetCompressionEnabled(bool value);
+
+  /**
+   * Returns true if the image frames in the disk cache are compressed as deltas against their
+   * previous frames. The default value is false.
+   */
+  static bool DeltaCompressionEnabled();
+
+  /**
+   * Sets whether the image frames in the disk cache are compressed as deltas against their previous
+   * frames, with a keyframe every few frames. Delta compression usually makes the cache files
+   * several times smaller for animations that only change a small region between frames, at the
+   * cost of decoding more than one frame when seeking. It has no effect if the compression is
+   * disabled. The setting only affects the cache files created afterward.
+   */
+  static void SetDeltaCompressionEnabled(bool value);
+
   /**
    * Removes all cached files from the disk. All the opened files will be also removed after they
    * are closed.
@@ -1878,6 +2029,56 @@ class PAG_API PAGDiskCache {
   static void RemoveAll();
 };
 
+/**
+ * Defines methods to manage the memory budget of the graphics caches, which is shared by all
+ * PAGPlayers in the process.
+ */
+class PAG_API PAGMemoryCache {
+ public:
+  /**
+   * Returns the memory budget in bytes shared by the graphics caches of all PAGPlayers. The
+   * default value is 300 MB.
+   */
+  static size_t MaxMemorySize();
+
+  /**
+   * Sets the memory budget in bytes shared by the graphics caches of all PAGPlayers. Once the
+   * total memory usage exceeds the budget, every PAGPlayer releases its share of the overage in
+   * proportion to its memory usage on its next flush, starting from its least valuable caches such
+   * as the snapshots that have been idle for the longest time. No new snapshot is created until the
+   * usage drops below the budget.
+   */
+  static void SetMaxMemorySize(size_t size);
+
+  /**
+   * Returns the total memory usage in bytes of the graphics caches of all PAGPlayers, including
+   * the GPU resources, the snapshots, the decoded images, the prefetched sequence frames, the idle
+   * frame buffers, and the encoded images kept for reuse.
+   */
+  static size_t MemoryUsage();
+
+  /**
+   * Returns the maximum number of frames that each layer caches for its transform, masks and
+   * content. 0 means no limit. The default value is 0.
+   */
+  static size_t MaxFrameCacheCount();
+
+  /**
+   * Sets the maximum number of frames that each layer caches for its transform, masks and content.
+   * Without a limit, a layer keeps the cache of every frame it has rendered until it is released,
+   * which may take a lot of memory for long-running players looping long animations. Once a layer
+   * reaches the limit, the frames that have not been reused recently are evicted. 0 means no
+   * limit.
+   */
+  static void SetMaxFrameCacheCount(size_t count);
+
+  /**
+   * Releases the embedded images that are kept alive for reuse after all the files containing them
+   * have been released. The images still used by any loaded file are not affected.
+   */
+  static void PurgeUnusedImages();
+};
+
 /**
  * Defines methods to control video decoding capabilities of PAG.
  */
@@ -1893,6 +2094,49 @@ class PAG_API PAGVideoDecoder {
    * decoding video sequences from a pag file, if hardware decoders are not available.
    */
   static void RegisterSoftwareDecoderFactory(SoftwareDecoderFactory* decoderFactory);
+
+  /**
+   * Returns the total number of threads that all built-in software video decoders can use
+   * together. 0 means the number of hardware threads of the device. The default value is 0.
+   */
+  static int SoftwareDecoderThreadBudget();
+
+  /**
+   * Sets the total number of threads that all built-in software video decoders can use together.
+   * The budget is divided evenly among the active software decoders each time they are opened or
+   * flushed, and every decoder always gets at least one thread. 0 means the number of hardware
+   * threads of the device.
+   */
+  static void SetSoftwareDecoderThreadBudget(int threadCount);
+
+  /**
+   * Returns the maximum number of threads that a single built-in software video decoder can use.
+   * The default value is 1.
+   */
+  static int MaxSoftwareDecoderThreads();
+
+  /**
+   * Sets the maximum number of threads that a single built-in software video decoder can use.
+   * Raising it speeds up the video sequences when no hardware decoder is available, at the cost of
+   * more CPU usage. Values less than 1 are treated as 1.
+   */
+  static void SetMaxSoftwareDecoderThreads(int threadCount);
+
+  /**
+   * Returns the maximum memory in bytes that each video sequence can use to keep its recently
+   * decoded frames for seeking. 0 means the seek cache is disabled. The default value is 0.
+   */
+  static size_t MaxSeekCacheBytes();
+
+  /**
+   * Sets the maximum memory in bytes that each video sequence can use to keep its recently
+   * decoded frames for seeking. Seeking backwards usually requires decoding again from the previous
+   * keyframe, which makes scrubbing and reverse playback slow. With the seek cache, the frames
+   * decoded on the way to the target frame are kept, and the frames farthest from the latest
+   * target are dropped first once the limit is reached. Only the frames of software decoders can
+   * be kept. 0 means the seek cache is disabled.
+   */
+  static void SetMaxSeekCacheBytes(size_t maxBytes);
 };
 
 class PAG_API PAG {
@@ -1577,6 +1577,12 @@ class PAG_API ByteData {
    * Creates a ByteData object from the specified file path.
    */
   static std::unique_ptr<ByteData> FromPath(const std::string& filePath);
+  /**
+   * Creates a ByteData object by memory-mapping the file at the specified path. The pages are
+   * shared with every other process that maps the same file, and are released when the returned
+   * ByteData is destroyed. Falls back to FromPath() on platforms without memory mapping support.
+   */
+  static std::unique_ptr<ByteData> MapFromPath(const std::string& filePath);
   /**
    * Creates a ByteData object and copy the specified data into it.
    */
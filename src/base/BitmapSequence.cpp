@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "base/utils/Verify.h"
+#include "codec/tags/BitmapSequence.h"
 #include "codec/utils/WebpDecoder.h"
 #include "pag/file.h"
 
@@ -44,33 +45,46 @@ BitmapSequence::~BitmapSequence() {
   }
 }
 
-bool BitmapSequence::isEmptyBitmapFrame(size_t frameIndex) {
+bool IsEmptyBitmap(int32_t x, int32_t y, const uint8_t* data, size_t length) {
   // There was a bug in PAGExporter that causes an empty frame being exported as 1x1 frame, so we
   // need to identify this kind of empty frame here.
+  if (x != 0 || y != 0) {
+    return false;
+  }
+  if (length > 150) {
+    return false;
+  }
+  int width = 0;
+  int height = 0;
+  if (!WebPGetInfo(data, length, &width, &height)) {
+    LOGE("Get webP size fail.");
+  }
+  return width <= 1 && height <= 1;
+}
+
+bool BitmapSequence::isEmptyBitmapFrame(size_t frameIndex) {
+  if (!deferredEmptyFrames.empty()) {
+    // Scanned when the frames were deferred, answers without decoding them.
+    return frameIndex < deferredEmptyFrames.size() && deferredEmptyFrames[frameIndex];
+  }
+  decodeDeferredFrames();
   if (frameIndex >= frames.size()) {
     return false;
   }
   auto frame = frames[frameIndex];
   for (auto bitmap : frame->bitmaps) {
-    if (bitmap->x != 0 || bitmap->y != 0) {
-      return false;
-    }
-    if (bitmap->fileBytes->length() > 150) {
-      return false;
-    }
-
-    int width = 0;
-    int height = 0;
-    if (!WebPGetInfo(bitmap->fileBytes->data(), bitmap->fileBytes->length(), &width, &height)) {
-      LOGE("Get webP size fail.");
-    }
-    if (width > 1 || height > 1) {
+    if (!IsEmptyBitmap(bitmap->x, bitmap->y, bitmap->fileBytes->data(),
+                       bitmap->fileBytes->length())) {
       return false;
     }
   }
   return true;
 }
 
+void BitmapSequence::setDeferredEmptyFrames(std::vector<bool> emptyFrames) {
+  deferredEmptyFrames = std::move(emptyFrames);
+}
+
 bool BitmapSequence::verify() const {
   if (!Sequence::verify() || frames.empty()) {
     VerifyFailed();
@@ -18,6 +18,14 @@
 
 #include "pag/file.h"
 #include "tgfx/core/Stream.h"
+#if defined(_WIN32)
+#include <windows.h>
+#elif !defined(__EMSCRIPTEN__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace pag {
 std::unique_ptr<ByteData> ByteData::FromPath(const std::string& filePath) {
@@ -33,6 +41,65 @@ std::unique_ptr<ByteData> ByteData::FromPath(const std::string& filePath) {
   return data;
 }
 
+#if defined(_WIN32)
+
+std::unique_ptr<ByteData> ByteData::MapFromPath(const std::string& filePath) {
+  auto file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                          FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  LARGE_INTEGER fileSize = {};
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+    CloseHandle(file);
+    return nullptr;
+  }
+  auto mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return nullptr;
+  }
+  auto address = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+  CloseHandle(mapping);
+  if (address == nullptr) {
+    return nullptr;
+  }
+  auto length = static_cast<size_t>(fileSize.QuadPart);
+  return MakeAdopted(reinterpret_cast<uint8_t*>(address), length,
+                     [](uint8_t* data) { UnmapViewOfFile(data); });
+}
+
+#elif defined(__EMSCRIPTEN__)
+
+std::unique_ptr<ByteData> ByteData::MapFromPath(const std::string& filePath) {
+  return FromPath(filePath);
+}
+
+#else
+
+std::unique_ptr<ByteData> ByteData::MapFromPath(const std::string& filePath) {
+  auto fd = open(filePath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat stats = {};
+  if (fstat(fd, &stats) != 0 || stats.st_size <= 0) {
+    close(fd);
+    return nullptr;
+  }
+  auto length = static_cast<size_t>(stats.st_size);
+  // Map the file as copy-on-write, the pages stay shared with other processes until written.
+  auto address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    return nullptr;
+  }
+  return MakeAdopted(reinterpret_cast<uint8_t*>(address), length,
+                     [length](uint8_t* data) { munmap(data, length); });
+}
+
+#endif
+
 std::unique_ptr<ByteData> ByteData::MakeCopy(const void* bytes, size_t length) {
   if (length == 0) {
     return Make(0);
@@ -27,6 +27,10 @@ static std::mutex globalLocker = {};
 static std::unordered_map<std::string, std::weak_ptr<File>> weakFileMap =
     std::unordered_map<std::string, std::weak_ptr<File>>();
 
+static std::atomic_bool lazyDecodingEnabled = {false};
+static std::atomic_bool parallelDecodingEnabled = {false};
+static std::atomic_bool keyframeBakingEnabled = {false};
+
 static std::shared_ptr<File> FindFileByPath(const std::string& filePath) {
   std::lock_guard<std::mutex> autoLock(globalLocker);
   if (filePath.empty()) {
@@ -55,12 +59,32 @@ static std::shared_ptr<File> FindFileByPath(const std::string& filePath) {
   return nullptr;
 }
 
+static void AddFileToMap(const std::string& filePath, const std::shared_ptr<File>& file) {
+  if (file == nullptr) {
+    return;
+  }
+  std::lock_guard<std::mutex> autoLock(globalLocker);
+  std::weak_ptr<File> weak = file;
+  weakFileMap.insert(std::make_pair(filePath, std::move(weak)));
+}
+
 std::shared_ptr<File> File::Load(const std::string& filePath) {
+  auto file = FindFileByPath(filePath);
+  if (file != nullptr) {
+    return file;
+  }
   auto byteData = ByteData::FromPath(filePath);
   if (byteData == nullptr) {
     return nullptr;
   }
-  return pag::File::Load(byteData->data(), byteData->length(), filePath);
+  if (lazyDecodingEnabled) {
+    // The lazily decoded frames take over the bytes read from the path instead of a copy of them.
+    file = Codec::Decode(std::move(byteData), filePath, true);
+  } else {
+    file = Codec::Decode(byteData->data(), static_cast<uint32_t>(byteData->length()), filePath);
+  }
+  AddFileToMap(filePath, file);
+  return file;
 }
 
 std::shared_ptr<File> File::Load(const void* bytes, size_t length, const std::string& filePath) {
@@ -68,15 +92,54 @@ std::shared_ptr<File> File::Load(const void* bytes, size_t length, const std::st
   if (file != nullptr) {
     return file;
   }
-  file = Codec::Decode(bytes, static_cast<uint32_t>(length), filePath);
+  if (lazyDecodingEnabled) {
+    // The lazily decoded frames reference the source bytes, so keep one copy of them in the file.
+    file = Codec::Decode(ByteData::MakeCopy(bytes, length), filePath, true);
+  } else {
+    file = Codec::Decode(bytes, static_cast<uint32_t>(length), filePath);
+  }
+  AddFileToMap(filePath, file);
+  return file;
+}
+
+std::shared_ptr<File> File::LoadMapped(const std::string& filePath) {
+  auto file = FindFileByPath(filePath);
   if (file != nullptr) {
-    std::lock_guard<std::mutex> autoLock(globalLocker);
-    std::weak_ptr<File> weak = file;
-    weakFileMap.insert(std::make_pair(filePath, std::move(weak)));
+    return file;
+  }
+  auto byteData = ByteData::MapFromPath(filePath);
+  if (byteData == nullptr) {
+    return nullptr;
   }
+  file = Codec::Decode(std::move(byteData), filePath, lazyDecodingEnabled);
+  AddFileToMap(filePath, file);
   return file;
 }
 
+void File::SetLazyDecodingEnabled(bool enabled) {
+  lazyDecodingEnabled = enabled;
+}
+
+bool File::LazyDecodingEnabled() {
+  return lazyDecodingEnabled;
+}
+
+void File::SetParallelDecodingEnabled(bool enabled) {
+  parallelDecodingEnabled = enabled;
+}
+
+bool File::ParallelDecodingEnabled() {
+  return parallelDecodingEnabled;
+}
+
+void File::SetKeyframeBakingEnabled(bool enabled) {
+  keyframeBakingEnabled = enabled;
+}
+
+bool File::KeyframeBakingEnabled() {
+  return keyframeBakingEnabled;
+}
+
 uint16_t File::MaxSupportedTagLevel() {
   return Codec::MaxSupportedTagLevel();
 }
@@ -113,6 +176,8 @@ File::~File() {
   delete editableImages;
   delete editableTexts;
   delete imageScaleModes;
+  // The embedded payloads may reference the source bytes, release them last.
+  delete sourceBytes;
 }
 
 void File::updateEditables(Composition* composition) {
@@ -27,6 +27,7 @@ Layer::Layer() : uniqueID(UniqueID::Next()) {
 
 Layer::~Layer() {
   delete cache;
+  delete transformCache;
   delete transform;
   delete transform3D;
   delete timeRemap;
@@ -50,4 +50,28 @@ Frame Sequence::toSequenceFrame(Frame compositionFrame) {
   }
   return sequenceFrame;
 }
+
+void Sequence::decodeDeferredFrames() {
+  if (!deferredFrames.deferred.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> autoLock(deferredFrames.locker);
+  if (deferredFrames.decoder == nullptr) {
+    return;
+  }
+  auto decoder = std::move(deferredFrames.decoder);
+  deferredFrames.decoder = nullptr;
+  decoder();
+  deferredFrames.deferred.store(false, std::memory_order_release);
+}
+
+bool Sequence::hasDeferredFrames() const {
+  return deferredFrames.deferred.load(std::memory_order_acquire);
+}
+
+void Sequence::setDeferredFramesDecoder(std::function<void()> decoder) {
+  std::lock_guard<std::mutex> autoLock(deferredFrames.locker);
+  deferredFrames.decoder = std::move(decoder);
+  deferredFrames.deferred.store(deferredFrames.decoder != nullptr, std::memory_order_release);
+}
 }  // namespace pag
\ No newline at end of file
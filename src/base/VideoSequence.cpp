@@ -41,8 +41,10 @@ bool VideoSequence::verify() const {
     VerifyFailed();
     return false;
   }
-  auto frameNotNull = [](VideoFrame* frame) {
-    return frame != nullptr && frame->fileBytes != nullptr;
+  // The file bytes of deferred frames are decoded on their first access.
+  auto deferred = hasDeferredFrames();
+  auto frameNotNull = [deferred](VideoFrame* frame) {
+    return frame != nullptr && (deferred || frame->fileBytes != nullptr);
   };
   if (!std::all_of(frames.begin(), frames.end(), frameNotNull)) {
     VerifyFailed();
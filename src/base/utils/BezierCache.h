@@ -0,0 +1,138 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace pag {
+/**
+ * BezierCache shares the bezier paths built from the same points. The entries are spread over
+ * several shards by hash, each with its own lock, so threads building different paths rarely wait
+ * on each other. The cache only keeps weak references, and the number of entries in each shard is
+ * bounded.
+ */
+template <typename Key, typename Path, typename Hasher>
+class BezierCache {
+ public:
+  /**
+   * Returns the cached path of the key, or nullptr if it does not exist or has been released.
+   */
+  std::shared_ptr<Path> find(const Key& key) {
+    auto& shard = getShard(key);
+    std::lock_guard<std::mutex> autoLock(shard.locker);
+    auto result = shard.paths.find(key);
+    if (result != shard.paths.end()) {
+      auto path = result->second.lock();
+      if (path != nullptr) {
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return path;
+      }
+      shard.paths.erase(result);
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  /**
+   * Adds the path to the cache and returns it. If another thread has added a path of the same key
+   * in the meantime, returns that path instead.
+   */
+  std::shared_ptr<Path> add(const Key& key, std::shared_ptr<Path> path) {
+    auto& shard = getShard(key);
+    std::lock_guard<std::mutex> autoLock(shard.locker);
+    auto result = shard.paths.find(key);
+    if (result != shard.paths.end()) {
+      auto cachedPath = result->second.lock();
+      if (cachedPath != nullptr) {
+        return cachedPath;
+      }
+      result->second = path;
+      return path;
+    }
+    if (shard.paths.size() >= MaxShardSize) {
+      trimShard(&shard);
+    }
+    shard.paths.insert(std::make_pair(key, std::weak_ptr<Path>(path)));
+    return path;
+  }
+
+  /**
+   * Returns the number of lookups that found a cached path.
+   */
+  uint64_t hitCount() const {
+    return hits.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the number of lookups that did not find a cached path.
+   */
+  uint64_t missCount() const {
+    return misses.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the number of entries in the cache, including the expired ones not yet removed.
+   */
+  size_t size() {
+    size_t count = 0;
+    for (auto& shard : shards) {
+      std::lock_guard<std::mutex> autoLock(shard.locker);
+      count += shard.paths.size();
+    }
+    return count;
+  }
+
+ private:
+  static constexpr size_t ShardCount = 16;
+  static constexpr size_t MaxShardSize = 256;
+
+  struct Shard {
+    std::mutex locker = {};
+    std::unordered_map<Key, std::weak_ptr<Path>, Hasher> paths = {};
+  };
+
+  Shard shards[ShardCount];
+  std::atomic<uint64_t> hits = {0};
+  std::atomic<uint64_t> misses = {0};
+
+  Shard& getShard(const Key& key) {
+    // Mix the high bits in, the low bits of the hash are used by the map of the shard.
+    auto hash = Hasher()(key);
+    return shards[(hash ^ (hash >> 16)) % ShardCount];
+  }
+
+  static void trimShard(Shard* shard) {
+    auto& paths = shard->paths;
+    for (auto iter = paths.begin(); iter != paths.end();) {
+      if (iter->second.expired()) {
+        iter = paths.erase(iter);
+      } else {
+        iter++;
+      }
+    }
+    // The paths still in use are dropped from the cache, their owners keep them alive.
+    while (paths.size() >= MaxShardSize) {
+      paths.erase(paths.begin());
+    }
+  }
+};
+}  // namespace pag
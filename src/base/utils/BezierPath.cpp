@@ -17,8 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "BezierPath.h"
-#include <mutex>
-#include <unordered_map>
+#include "BezierCache.h"
 
 namespace pag {
 
@@ -122,26 +121,22 @@ size_t BezierHasher::operator()(const pag::BezierKey& key) const {
   return hash;
 }
 
-static std::unordered_map<BezierKey, std::weak_ptr<BezierPath>, BezierHasher> BezierCacheMap =
-    std::unordered_map<BezierKey, std::weak_ptr<BezierPath>, BezierHasher>{};
-static std::mutex locker = {};
+using BezierPathCache = BezierCache<BezierKey, BezierPath, BezierHasher>;
+
+static BezierPathCache* GetBezierPathCache() {
+  static auto& cache = *new BezierPathCache();
+  return &cache;
+}
 
 std::shared_ptr<BezierPath> BezierPath::Build(const pag::Point& start, const pag::Point& control1,
                                               const pag::Point& control2, const pag::Point& end,
                                               float precision) {
   Point points[] = {start, control1, control2, end};
   auto bezierKey = BezierKey::Make(points, precision);
-  {
-    std::lock_guard<std::mutex> autoLock(locker);
-    auto result = BezierCacheMap.find(bezierKey);
-    if (result != BezierCacheMap.end()) {
-      auto& weak = result->second;
-      auto data = weak.lock();
-      if (data) {
-        return data;
-      }
-      BezierCacheMap.erase(result);
-    }
+  auto cache = GetBezierPathCache();
+  auto cachedPath = cache->find(bezierKey);
+  if (cachedPath != nullptr) {
+    return cachedPath;
   }
 
   auto bezierPath = std::shared_ptr<BezierPath>(new BezierPath());
@@ -156,12 +151,15 @@ std::shared_ptr<BezierPath> BezierPath::Build(const pag::Point& start, const pag
     bezierPath->length =
         BuildCubicSegments(points, 0, 0, MaxBezierTValue, bezierPath->segments, precision);
   }
-  {
-    std::lock_guard<std::mutex> autoLock(locker);
-    std::weak_ptr<BezierPath> weak = bezierPath;
-    BezierCacheMap.insert(std::make_pair(bezierKey, std::move(weak)));
-  }
-  return bezierPath;
+  return cache->add(bezierKey, bezierPath);
+}
+
+uint64_t BezierPath::CacheHitCount() {
+  return GetBezierPathCache()->hitCount();
+}
+
+uint64_t BezierPath::CacheMissCount() {
+  return GetBezierPathCache()->missCount();
 }
 
 Point BezierPath::getPosition(float percent) const {
@@ -83,6 +83,16 @@ class BezierPath {
    */
   float getLength() const;
 
+  /**
+   * Returns the number of Build() calls that reused a cached path.
+   */
+  static uint64_t CacheHitCount();
+
+  /**
+   * Returns the number of Build() calls that created a new path.
+   */
+  static uint64_t CacheMissCount();
+
  private:
   float length = 0;
   std::vector<BezierSegment> segments;
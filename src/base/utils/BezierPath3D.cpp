@@ -17,8 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "BezierPath3D.h"
-#include <mutex>
-#include <unordered_map>
+#include "BezierCache.h"
 
 namespace pag {
 
@@ -131,9 +130,12 @@ size_t BezierHasher3D::operator()(const pag::BezierKey3D& key) const {
   return hash;
 }
 
-static std::unordered_map<BezierKey3D, std::weak_ptr<BezierPath3D>, BezierHasher3D> BezierCacheMap =
-    std::unordered_map<BezierKey3D, std::weak_ptr<BezierPath3D>, BezierHasher3D>{};
-static std::mutex locker = {};
+using BezierPath3DCache = BezierCache<BezierKey3D, BezierPath3D, BezierHasher3D>;
+
+static BezierPath3DCache* GetBezierPath3DCache() {
+  static auto& cache = *new BezierPath3DCache();
+  return &cache;
+}
 
 std::shared_ptr<BezierPath3D> BezierPath3D::Build(const pag::Point3D& start,
                                                   const pag::Point3D& control1,
@@ -141,17 +143,10 @@ std::shared_ptr<BezierPath3D> BezierPath3D::Build(const pag::Point3D& start,
                                                   const pag::Point3D& end, float precision) {
   Point3D points[] = {start, control1, control2, end};
   auto bezierKey = BezierKey3D::Make(points, precision);
-  {
-    std::lock_guard<std::mutex> autoLock(locker);
-    auto result = BezierCacheMap.find(bezierKey);
-    if (result != BezierCacheMap.end()) {
-      auto& weak = result->second;
-      auto data = weak.lock();
-      if (data) {
-        return data;
-      }
-      BezierCacheMap.erase(result);
-    }
+  auto cache = GetBezierPath3DCache();
+  auto cachedPath = cache->find(bezierKey);
+  if (cachedPath != nullptr) {
+    return cachedPath;
   }
 
   auto bezierPath = std::shared_ptr<BezierPath3D>(new BezierPath3D());
@@ -166,12 +161,7 @@ std::shared_ptr<BezierPath3D> BezierPath3D::Build(const pag::Point3D& start,
     bezierPath->length =
         BuildCubicSegments(points, 0, 0, MaxBezierTValue, bezierPath->segments, precision);
   }
-  {
-    std::lock_guard<std::mutex> autoLock(locker);
-    std::weak_ptr<BezierPath3D> weak = bezierPath;
-    BezierCacheMap.insert(std::make_pair(bezierKey, std::move(weak)));
-  }
-  return bezierPath;
+  return cache->add(bezierKey, bezierPath);
 }
 
 Point3D BezierPath3D::getPosition(float percent) const {
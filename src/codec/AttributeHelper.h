@@ -273,7 +273,10 @@ Property<T>* ReadProperty(DecodeStream* stream, const AttributeConfig<T>& config
       if (flag.hasSpatial) {
         ReadSpatialEase(stream, keyframes);
       }
-      property = new AnimatableProperty<T>(keyframes);
+      auto animatableProperty = new AnimatableProperty<T>(keyframes);
+      auto context = static_cast<CodecContext*>(stream->context);
+      animatableProperty->setBakingEnabled(context->bakeKeyframes);
+      property = animatableProperty;
     } else {
       property = new Property<T>();
       property->value = ReadValue(stream, config, flag);
@@ -25,6 +25,8 @@
 #include "codec/tags/FileTags.h"
 #include "codec/tags/PerformanceTag.h"
 #include "pag/file.h"
+#include "rendering/utils/LZ4Decoder.h"
+#include "rendering/utils/LZ4Encoder.h"
 
 namespace pag {
 
@@ -32,6 +34,9 @@ static const uint8_t EncryptedVersion = 3;
 
 static const uint8_t KnownVersion = 3;
 
+// LZ4 never expands a block by more than 255 times, which bounds the length of a valid body.
+static const uint64_t LZ4MaxExpansionRatio = 255;
+
 static bool HasTrackMatte(TrackMatteType type) {
   switch (type) {
     case TrackMatteType::Alpha:
@@ -175,7 +180,35 @@ std::shared_ptr<File> Codec::VerifyAndMake(const std::vector<pag::Composition*>&
   return std::shared_ptr<File>(file);
 }
 
-DecodeStream ReadBodyBytes(DecodeStream* stream) {
+static std::unique_ptr<ByteData> DecompressBody(DecodeStream* stream, uint32_t bodyLength) {
+  auto compressedLength = stream->readUint32();
+  auto compressedBytes = stream->readBytes(compressedLength);
+  if (stream->context->hasException()) {
+    return nullptr;
+  }
+  // The body length comes from the file, rejects it before allocating if the compressed bytes can
+  // never expand to it.
+  if (bodyLength > static_cast<uint64_t>(compressedBytes.length()) * LZ4MaxExpansionRatio) {
+    PAGThrowError(stream->context, "Invalid PAG file header.");
+    return nullptr;
+  }
+  // Decompress straight into the buffer that backs the body stream, no intermediate copy needed.
+  auto bodyData = ByteData::Make(bodyLength);
+  if (bodyData->length() != bodyLength) {
+    PAGThrowError(stream->context, "Out of memory.");
+    return nullptr;
+  }
+  auto decoder = LZ4Decoder::MakeRaw();
+  auto size = decoder->decode(bodyData->data(), bodyLength, compressedBytes.data(),
+                              compressedBytes.length());
+  if (size != bodyLength) {
+    PAGThrowError(stream->context, "Failed to decompress the PAG file body.");
+    return nullptr;
+  }
+  return bodyData;
+}
+
+DecodeStream ReadBodyBytes(DecodeStream* stream, std::unique_ptr<ByteData>* bodyData) {
   DecodeStream emptyStream(stream->context);
   if (stream->length() < 11) {
     PAGThrowError(stream->context, "Length of PAG file is too short.");
@@ -199,6 +232,13 @@ DecodeStream ReadBodyBytes(DecodeStream* stream) {
   }
   auto bodyLength = stream->readUint32();
   auto compression = stream->readInt8();
+  if (compression == CompressionAlgorithm::LZ4) {
+    *bodyData = DecompressBody(stream, bodyLength);
+    if (*bodyData == nullptr) {
+      return emptyStream;
+    }
+    return DecodeStream(stream->context, (*bodyData)->data(), bodyLength);
+  }
   if (compression != CompressionAlgorithm::UNCOMPRESSED) {
     PAGThrowError(stream->context, "Invalid PAG file header.");
     return emptyStream;
@@ -210,27 +250,62 @@ DecodeStream ReadBodyBytes(DecodeStream* stream) {
 std::shared_ptr<File> Codec::Decode(const void* bytes, uint32_t byteLength,
                                     const std::string& filePath) {
   CodecContext context = {};
-  DecodeStream stream(&context, reinterpret_cast<const uint8_t*>(bytes), byteLength);
-  auto bodyBytes = ReadBodyBytes(&stream);
-  if (context.hasException()) {
+  context.parallelDecoding = File::ParallelDecodingEnabled();
+  context.bakeKeyframes = File::KeyframeBakingEnabled();
+  return Decode(&context, bytes, byteLength, filePath);
+}
+
+std::shared_ptr<File> Codec::Decode(std::unique_ptr<ByteData> byteData,
+                                    const std::string& filePath, bool lazyDecoding) {
+  if (byteData == nullptr || byteData->length() > UINT32_MAX) {
     return nullptr;
   }
-  ReadTags(&bodyBytes, &context, ReadTagsOfFile);
-  if (context.hasException()) {
+  CodecContext context = {};
+  context.shareSourceBytes = true;
+  context.lazyDecoding = lazyDecoding;
+  context.parallelDecoding = File::ParallelDecodingEnabled();
+  context.bakeKeyframes = File::KeyframeBakingEnabled();
+  auto file =
+      Decode(&context, byteData->data(), static_cast<uint32_t>(byteData->length()), filePath);
+  // The file already owns the decompressed body if it was compressed.
+  if (file != nullptr && file->sourceBytes == nullptr) {
+    file->sourceBytes = byteData.release();
+  }
+  return file;
+}
+
+std::shared_ptr<File> Codec::Decode(CodecContext* context, const void* bytes, uint32_t byteLength,
+                                    const std::string& filePath) {
+  DecodeStream stream(context, reinterpret_cast<const uint8_t*>(bytes), byteLength);
+  std::unique_ptr<ByteData> bodyData = nullptr;
+  auto bodyBytes = ReadBodyBytes(&stream, &bodyData);
+  if (context->hasException()) {
     return nullptr;
   }
-  InstallReferences(context.compositions);
-  if (context.hasException()) {
+  if (context->parallelDecoding) {
+    ReadTagsOfFileInParallel(&bodyBytes, context);
+  } else {
+    ReadTags(&bodyBytes, context, ReadTagsOfFile);
+  }
+  if (context->hasException()) {
+    return nullptr;
+  }
+  InstallReferences(context->compositions);
+  if (context->hasException()) {
     return nullptr;
   }
 
   // Verify 提前到使用之前，避免未经Verify导致使用时crash
-  auto file = VerifyAndMake(context.releaseCompositions(), context.releaseImages());
+  auto file = VerifyAndMake(context->releaseCompositions(), context->releaseImages());
   if (file == nullptr) {
     return nullptr;
   }
 
-  UpdateFileAttributes(file, &context, filePath);
+  UpdateFileAttributes(file, context, filePath);
+  if (bodyData != nullptr && context->shareSourceBytes) {
+    // The decoded payloads reference the decompressed body directly.
+    file->sourceBytes = bodyData.release();
+  }
   return file;
 }
 
@@ -239,7 +314,8 @@ std::unique_ptr<ByteData> Codec::Encode(std::shared_ptr<File> file) {
 }
 
 std::unique_ptr<ByteData> Codec::Encode(std::shared_ptr<File> file,
-                                        std::shared_ptr<PerformanceData> performanceData) {
+                                        std::shared_ptr<PerformanceData> performanceData,
+                                        BodyCompression compression) {
   CodecContext context = {};
   EncodeStream bodyBytes(&context);
   WriteTagsOfFile(&bodyBytes, file.get(), performanceData.get());
@@ -250,6 +326,24 @@ std::unique_ptr<ByteData> Codec::Encode(std::shared_ptr<File> file,
   fileBytes.writeInt8('G');
   fileBytes.writeUint8(Version);
   fileBytes.writeUint32(bodyBytes.length());
+  if (compression == BodyCompression::LZ4) {
+    auto bodyData = bodyBytes.release();
+    auto encoder = LZ4Encoder::MakeRaw();
+    auto maxLength = LZ4Encoder::GetMaxOutputSize(bodyData->length());
+    auto compressedData = ByteData::Make(maxLength);
+    auto compressedLength = encoder->encode(compressedData->data(), compressedData->length(),
+                                            bodyData->data(), bodyData->length());
+    // Falls back to the uncompressed body if it can not be compressed.
+    if (compressedLength > 0 && compressedLength < bodyData->length()) {
+      fileBytes.writeInt8(CompressionAlgorithm::LZ4);
+      fileBytes.writeUint32(static_cast<uint32_t>(compressedLength));
+      fileBytes.writeBytes(compressedData->data(), static_cast<uint32_t>(compressedLength));
+    } else {
+      fileBytes.writeInt8(CompressionAlgorithm::UNCOMPRESSED);
+      fileBytes.writeBytes(bodyData->data(), static_cast<uint32_t>(bodyData->length()));
+    }
+    return fileBytes.release();
+  }
   fileBytes.writeInt8(CompressionAlgorithm::UNCOMPRESSED);
   fileBytes.writeBytes(&bodyBytes);
   return fileBytes.release();
@@ -259,7 +353,8 @@ std::shared_ptr<PerformanceData> Codec::ReadPerformanceData(const void* bytes,
                                                             uint32_t byteLength) {
   CodecContext context = {};
   DecodeStream stream(&context, reinterpret_cast<const uint8_t*>(bytes), byteLength);
-  auto bodyBytes = ReadBodyBytes(&stream);
+  std::unique_ptr<ByteData> bodyData = nullptr;
+  auto bodyBytes = ReadBodyBytes(&stream, &bodyData);
   if (context.hasException()) {
     return nullptr;
   }
@@ -19,6 +19,12 @@
 #include "CodecContext.h"
 
 namespace pag {
+CodecContext::CodecContext(CodecContext* parent) : parent(parent) {
+  shareSourceBytes = parent->shareSourceBytes;
+  lazyDecoding = parent->lazyDecoding;
+  bakeKeyframes = parent->bakeKeyframes;
+}
+
 CodecContext::~CodecContext() {
   for (auto& font : fontIDMap) {
     delete font.second;
@@ -41,6 +47,10 @@ CodecContext::~CodecContext() {
 }
 
 FontData CodecContext::getFontData(int id) {
+  if (parent != nullptr) {
+    // The font tables are never modified while the compositions are being decoded.
+    return parent->getFontData(id);
+  }
   auto result = fontIDMap.find(id);
   if (result != fontIDMap.end()) {
     auto font = result->second;
@@ -50,6 +60,10 @@ FontData CodecContext::getFontData(int id) {
 }
 
 ImageBytes* CodecContext::getImageBytes(pag::ID imageID) {
+  if (parent != nullptr) {
+    std::lock_guard<std::mutex> autoLock(parent->locker);
+    return parent->getImageBytes(imageID);
+  }
   for (auto image : images) {
     if (image->id == imageID) {
       return image;
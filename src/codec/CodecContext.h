@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <unordered_map>
 #include "codec/utils/StreamContext.h"
 #include "pag/file.h"
@@ -31,6 +32,14 @@ struct FontDescriptor {
 
 class CodecContext : public StreamContext {
  public:
+  CodecContext() = default;
+
+  /**
+   * Creates a child context to decode a composition on another thread. The child context reads
+   * the fonts and images from the parent context, which must outlive it.
+   */
+  explicit CodecContext(CodecContext* parent);
+
   ~CodecContext() override;
   uint32_t getFontID(const std::string& fontFamily, const std::string& fontStyle);
   FontData getFontData(int id);
@@ -51,5 +60,16 @@ class CodecContext : public StreamContext {
   std::vector<int>* editableTexts = nullptr;
   std::vector<PAGScaleMode>* imageScaleModes = nullptr;
   uint16_t tagLevel = 0;
+  // If true, the frames of sequences are decoded on their first access, it requires the source
+  // bytes to be shared.
+  bool lazyDecoding = false;
+  // If true, the composition tags of the file are decoded concurrently.
+  bool parallelDecoding = false;
+  // If true, the animatable properties bake their values on the first access.
+  bool bakeKeyframes = false;
+
+ private:
+  CodecContext* parent = nullptr;
+  std::mutex locker = {};
 };
 }  // namespace pag
@@ -23,5 +23,6 @@ namespace CompressionAlgorithm {
 static const char UNCOMPRESSED = 'U';
 static const char ZLIB = 'Z';
 static const char LZMA = 'L';
+static const char LZ4 = '4';
 };  // namespace CompressionAlgorithm
 }  // namespace pag
@@ -178,6 +178,7 @@ std::unique_ptr<ByteData> MP4BoxHelper::CovertToMP4(const VideoSequence* videoSe
 }
 
 void MP4BoxHelper::WriteMP4Header(VideoSequence* videoSequence) {
+  videoSequence->decodeDeferredFrames();
   videoSequence->MP4Header = MakeMP4Data(videoSequence, false).release();
 }
 }  // namespace pag
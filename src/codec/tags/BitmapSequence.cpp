@@ -19,6 +19,68 @@
 #include "BitmapSequence.h"
 
 namespace pag {
+static void ReadBitmapFrames(DecodeStream* stream, BitmapSequence* sequence) {
+  for (auto bitmapFrame : sequence->frames) {
+    uint32_t bitmapCount = stream->readEncodedUint32();
+    for (uint32_t j = 0; j < bitmapCount; j++) {
+      if (stream->context->hasException()) {
+        break;
+      }
+      auto bitmap = new BitmapRect();
+      bitmapFrame->bitmaps.push_back(bitmap);
+      bitmap->x = stream->readEncodedInt32();
+      bitmap->y = stream->readEncodedInt32();
+      bitmap->fileBytes = stream->readByteData().release();
+    }
+  }
+}
+
+static void DecodeDeferredBitmapFrames(BitmapSequence* sequence, const uint8_t* data,
+                                       uint32_t length) {
+  CodecContext context = {};
+  context.shareSourceBytes = true;
+  DecodeStream stream(&context, data, length);
+  ReadBitmapFrames(&stream, sequence);
+  if (!context.hasException()) {
+    return;
+  }
+  LOGE("Failed to decode the deferred frames of a BitmapSequence.");
+  // Drop the broken bitmaps, so that the readers never see a null fileBytes.
+  for (auto bitmapFrame : sequence->frames) {
+    auto& bitmaps = bitmapFrame->bitmaps;
+    for (auto i = static_cast<int>(bitmaps.size()) - 1; i >= 0; i--) {
+      if (bitmaps[i]->fileBytes == nullptr) {
+        delete bitmaps[i];
+        bitmaps.erase(bitmaps.begin() + i);
+      }
+    }
+  }
+}
+
+// Finds the empty frames without creating the bitmaps, returns an empty list if the data is broken.
+static std::vector<bool> ScanEmptyBitmapFrames(const uint8_t* data, uint32_t length,
+                                               size_t frameCount) {
+  CodecContext context = {};
+  DecodeStream stream(&context, data, length);
+  std::vector<bool> emptyFrames(frameCount, true);
+  for (size_t i = 0; i < frameCount; i++) {
+    uint32_t bitmapCount = stream.readEncodedUint32();
+    for (uint32_t j = 0; j < bitmapCount; j++) {
+      auto x = stream.readEncodedInt32();
+      auto y = stream.readEncodedInt32();
+      auto byteLength = stream.readEncodedUint32();
+      auto bytes = stream.readBytes(byteLength);
+      if (context.hasException()) {
+        return {};
+      }
+      if (emptyFrames[i] && !IsEmptyBitmap(x, y, bytes.data(), bytes.length())) {
+        emptyFrames[i] = false;
+      }
+    }
+  }
+  return emptyFrames;
+}
+
 BitmapSequence* ReadBitmapSequence(DecodeStream* stream) {
   auto sequence = new BitmapSequence();
   sequence->width = stream->readEncodedInt32();
@@ -33,24 +95,24 @@ BitmapSequence* ReadBitmapSequence(DecodeStream* stream) {
     sequence->frames.push_back(bitmapFrame);
     bitmapFrame->isKeyframe = stream->readBitBoolean();
   }
-  for (uint32_t i = 0; i < count; i++) {
-    auto bitmapFrame = sequence->frames[i];
-    uint32_t bitmapCount = stream->readEncodedUint32();
-    for (uint32_t j = 0; j < bitmapCount; j++) {
-      if (stream->context->hasException()) {
-        break;
-      }
-      auto bitmap = new BitmapRect();
-      bitmapFrame->bitmaps.push_back(bitmap);
-      bitmap->x = stream->readEncodedInt32();
-      bitmap->y = stream->readEncodedInt32();
-      bitmap->fileBytes = stream->readByteData().release();
-    }
+  auto context = static_cast<CodecContext*>(stream->context);
+  if (context->lazyDecoding && !context->hasException()) {
+    // Only record where the bitmaps are, they are decoded on the first access.
+    auto bytes = stream->readBytes(stream->bytesAvailable());
+    auto data = bytes.data();
+    auto length = bytes.length();
+    sequence->setDeferredEmptyFrames(ScanEmptyBitmapFrames(data, length, sequence->frames.size()));
+    sequence->setDeferredFramesDecoder([sequence, data, length]() {
+      DecodeDeferredBitmapFrames(sequence, data, length);
+    });
+    return sequence;
   }
+  ReadBitmapFrames(stream, sequence);
   return sequence;
 }
 
 TagCode WriteBitmapSequence(EncodeStream* stream, BitmapSequence* sequence) {
+  sequence->decodeDeferredFrames();
   stream->writeEncodedInt32(sequence->width);
   stream->writeEncodedInt32(sequence->height);
   stream->writeFloat(sequence->frameRate);
@@ -22,5 +22,9 @@
 
 namespace pag {
 BitmapSequence* ReadBitmapSequence(DecodeStream* stream);
+/**
+ * Returns true if the bitmap is an empty frame exported as a 1x1 frame by an old PAGExporter.
+ */
+bool IsEmptyBitmap(int32_t x, int32_t y, const uint8_t* data, size_t length);
 TagCode WriteBitmapSequence(EncodeStream* stream, BitmapSequence* sequence);
 }  // namespace pag
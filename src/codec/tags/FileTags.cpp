@@ -29,6 +29,7 @@
 #include "codec/tags/TimeStretchMode.h"
 #include "codec/tags/VectorCompositionTag.h"
 #include "codec/tags/VideoCompositionTag.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
 static void ReadTag_FontTables(DecodeStream* stream, CodecContext*) {
@@ -108,6 +109,70 @@ void ReadTagsOfFile(DecodeStream* stream, TagCode code, CodecContext* context) {
   }
 }
 
+static bool IsCompositionTag(TagCode code) {
+  return code == TagCode::VectorCompositionBlock || code == TagCode::BitmapCompositionBlock ||
+         code == TagCode::VideoCompositionBlock;
+}
+
+struct CompositionBlock {
+  CompositionBlock(CodecContext* parent, TagCode code, DecodeStream tagBytes)
+      : context(parent), code(code), tagBytes(std::move(tagBytes)) {
+    this->tagBytes.context = &context;
+  }
+
+  CodecContext context;
+  TagCode code;
+  DecodeStream tagBytes;
+  std::shared_ptr<tgfx::Task> task = nullptr;
+};
+
+void ReadTagsOfFileInParallel(DecodeStream* stream, CodecContext* context) {
+  // The first pass indexes the composition tags and reads all other tags, which are small and
+  // required by the compositions, such as the font tables and images.
+  std::vector<std::unique_ptr<CompositionBlock>> blocks = {};
+  auto header = ReadTagHeader(stream);
+  while (!context->hasException() && header.code != TagCode::End) {
+    auto tagBytes = stream->readBytes(header.length);
+    if (IsCompositionTag(header.code)) {
+      blocks.push_back(std::make_unique<CompositionBlock>(context, header.code, tagBytes));
+    } else {
+      ReadTagsOfFile(&tagBytes, header.code, context);
+    }
+    if (context->hasException()) {
+      return;
+    }
+    header = ReadTagHeader(stream);
+  }
+  if (context->hasException()) {
+    return;
+  }
+  for (size_t i = 1; i < blocks.size(); i++) {
+    auto block = blocks[i].get();
+    block->task = tgfx::Task::Run([block]() {
+      ReadTagsOfFile(&block->tagBytes, block->code, &block->context);
+    });
+  }
+  // Decode the first composition on the current thread while waiting for others.
+  if (!blocks.empty()) {
+    auto block = blocks[0].get();
+    ReadTagsOfFile(&block->tagBytes, block->code, &block->context);
+  }
+  for (auto& block : blocks) {
+    if (block->task != nullptr) {
+      block->task->wait();
+    }
+    for (auto& message : block->context.StreamContext::errorMessages) {
+      context->throwException(message);
+    }
+    if (context->tagLevel < block->context.tagLevel) {
+      context->tagLevel = block->context.tagLevel;
+    }
+    auto compositions = block->context.releaseCompositions();
+    context->compositions.insert(context->compositions.end(), compositions.begin(),
+                                 compositions.end());
+  }
+}
+
 void GetFontFromTextDocument(std::vector<FontData>& fontList,
                              std::unordered_set<std::string>& fontSet,
                              const TextDocumentHandle& textDocument) {
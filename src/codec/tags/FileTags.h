@@ -23,6 +23,12 @@
 namespace pag {
 void ReadTagsOfFile(DecodeStream* stream, TagCode code, CodecContext* context);
 
+/**
+ * Reads all tags of the file body like ReadTags(stream, context, ReadTagsOfFile), but decodes the
+ * composition tags concurrently. The decoded compositions keep the order of the file.
+ */
+void ReadTagsOfFileInParallel(DecodeStream* stream, CodecContext* context);
+
 void WriteTagsOfFile(EncodeStream* stream, const File* file, PerformanceData* performanceData);
 
 std::vector<FontData> GetFontList(std::vector<Composition*> compositions);
@@ -20,6 +20,16 @@
 #include "codec/utils/NALUReader.h"
 
 namespace pag {
+static void ReadVideoFrames(DecodeStream* stream, VideoSequence* sequence) {
+  for (auto videoFrame : sequence->frames) {
+    if (stream->context->hasException()) {
+      return;
+    }
+    videoFrame->frame = ReadTime(stream);
+    videoFrame->fileBytes = ReadByteDataWithStartCode(stream).release();
+  }
+}
+
 VideoSequence* ReadVideoSequence(DecodeStream* stream, bool hasAlpha) {
   auto sequence = new VideoSequence();
   sequence->width = stream->readEncodedInt32();
@@ -45,13 +55,30 @@ VideoSequence* ReadVideoSequence(DecodeStream* stream, bool hasAlpha) {
     sequence->frames.push_back(videoFrame);
     videoFrame->isKeyframe = stream->readBitBoolean();
   }
-  for (uint32_t i = 0; i < count; i++) {
-    if (stream->context->hasException()) {
-      return sequence;
+  auto context = static_cast<CodecContext*>(stream->context);
+  if (context->lazyDecoding) {
+    // Walk over the frames to reach the static time ranges, and only record where the frames are,
+    // they are decoded on the first access.
+    auto start = stream->position();
+    for (auto videoFrame : sequence->frames) {
+      if (context->hasException()) {
+        return sequence;
+      }
+      videoFrame->frame = ReadTime(stream);
+      stream->skip(stream->readEncodedUint32());
     }
-    auto videoFrame = sequence->frames[i];
-    videoFrame->frame = ReadTime(stream);
-    videoFrame->fileBytes = ReadByteDataWithStartCode(stream).release();
+    auto data = stream->data() + start;
+    auto length = stream->position() - start;
+    sequence->setDeferredFramesDecoder([sequence, data, length]() {
+      CodecContext context = {};
+      DecodeStream stream(&context, data, length);
+      ReadVideoFrames(&stream, sequence);
+      if (context.hasException()) {
+        LOGE("Failed to decode the deferred frames of a VideoSequence.");
+      }
+    });
+  } else {
+    ReadVideoFrames(stream, sequence);
   }
 
   if (stream->bytesAvailable() > 0) {
@@ -84,6 +111,7 @@ static void WriteByteDataWithoutStartCode(EncodeStream* stream, ByteData* byteDa
 
 TagCode WriteVideoSequence(EncodeStream* stream, std::pair<VideoSequence*, bool>* parameter) {
   auto sequence = parameter->first;
+  sequence->decodeDeferredFrames();
   auto hasAlpha = parameter->second;
   stream->writeEncodedInt32(sequence->width);
   stream->writeEncodedInt32(sequence->height);
@@ -124,6 +152,9 @@ ByteData* ReadMp4Header(DecodeStream* stream) {
   if (length == 0 || length > bytes.length() || stream->context->hasException()) {
     return nullptr;
   }
+  if (stream->context->shareSourceBytes) {
+    return ByteData::MakeWithoutCopy(const_cast<uint8_t*>(bytes.data()), length).release();
+  }
   auto data = new (std::nothrow) uint8_t[length];
   if (data == nullptr) {
     return nullptr;
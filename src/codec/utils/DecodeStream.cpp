@@ -147,6 +147,9 @@ std::unique_ptr<ByteData> DecodeStream::readByteData() {
   if (length == 0 || length > bytes.length() || context->hasException()) {
     return nullptr;
   }
+  if (context->shareSourceBytes) {
+    return ByteData::MakeWithoutCopy(const_cast<uint8_t*>(bytes.data()), length);
+  }
   return ByteData::MakeCopy(bytes.data(), length);
 }
 
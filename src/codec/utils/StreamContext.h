@@ -44,6 +44,13 @@ class StreamContext {
   }
 
   std::vector<std::string> errorMessages;
+
+  /**
+   * If true, the ByteData objects read from the stream reference the source bytes directly instead
+   * of copying them. The owner of the source bytes must keep them alive as long as the decoded
+   * objects are in use.
+   */
+  bool shareSourceBytes = false;
 };
 
 inline size_t BitsToBytes(size_t capacity) {
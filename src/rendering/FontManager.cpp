@@ -20,6 +20,7 @@
 #include "base/utils/USE.h"
 #include "pag/file.h"
 #include "platform/Platform.h"
+#include "rendering/utils/shaper/TextShaper.h"
 
 namespace pag {
 std::shared_ptr<TypefaceHolder> TypefaceHolder::MakeFromName(const std::string& fontFamily,
@@ -210,10 +211,13 @@ void FontManager::UnregisterFont(const PAGFont& font) {
 
 void FontManager::SetFallbackFontNames(const std::vector<std::string>& fontNames) {
   fontManager.setFallbackFontNames(fontNames);
+  // The shaped texts may use the previous fallback fonts.
+  TextShaper::PurgeCaches();
 }
 
 void FontManager::SetFallbackFontPaths(const std::vector<std::string>& fontPaths,
                                        const std::vector<int>& ttcIndices) {
   fontManager.setFallbackFontPaths(fontPaths, ttcIndices);
+  TextShaper::PurgeCaches();
 }
 }  // namespace pag
@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <platform/Platform.h>
+#include <thread>
 #include "base/utils/Log.h"
 #include "base/utils/TGFXCast.h"
 #include "base/utils/TimeUtil.h"
@@ -26,8 +27,64 @@
 #include "rendering/layers/ContentVersion.h"
 #include "rendering/utils/BitmapBuffer.h"
 #include "rendering/utils/LockGuard.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
+static constexpr int MIN_FRAMES_PER_SHARD = 4;
+
+using FrameCallback = std::function<void(int, const void*, size_t)>;
+
+class FrameShard {
+ public:
+  FrameShard(int startIndex, int endIndex, const tgfx::ImageInfo& info)
+      : startIndex(startIndex), endIndex(endIndex), buffer(info.byteSize()) {
+    bitmap = BitmapBuffer::Wrap(info, buffer.data());
+  }
+
+  int startIndex = 0;
+  int endIndex = 0;
+  tgfx::Buffer buffer = {};
+  std::shared_ptr<BitmapBuffer> bitmap = nullptr;
+  std::shared_ptr<tgfx::Task> task = nullptr;
+  bool success = false;
+};
+
+static int GetShardCount(int maxThreads, int frameCount) {
+  auto count = maxThreads;
+  if (count <= 0) {
+    count = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  return std::max(1, std::min(count, frameCount / MIN_FRAMES_PER_SHARD));
+}
+
+static bool ReadFrameRange(SequenceFile* sequenceFile, FrameShard* shard,
+                           const std::function<bool(int)>& renderFrame,
+                           const FrameCallback& callback) {
+  if (shard->bitmap == nullptr) {
+    LOGE("PAGDecoder::readFrames() Failed to allocate the frame buffer!");
+    return false;
+  }
+  auto success = true;
+  auto rowBytes = shard->bitmap->info().rowBytes();
+  for (int index = shard->startIndex; index < shard->endIndex; index++) {
+    auto mappedPixels = sequenceFile->mapFrame(index);
+    if (mappedPixels != nullptr) {
+      callback(index, mappedPixels, rowBytes);
+      continue;
+    }
+    if (!sequenceFile->readFrame(index, shard->bitmap)) {
+      if (!renderFrame(index)) {
+        success = false;
+        continue;
+      }
+      // Ignore the result here, another shard may have already written a frame of the same static
+      // time range.
+      sequenceFile->writeFrame(index, shard->bitmap);
+    }
+    callback(index, shard->buffer.data(), rowBytes);
+  }
+  return success;
+}
 
 static std::string DefaultCacheKeyGeneratorFunc(PAGDecoder* decoder,
                                                 std::shared_ptr<PAGComposition> composition) {
@@ -191,22 +248,98 @@ bool PAGDecoder::readFrameInternal(int index, std::shared_ptr<BitmapBuffer> bitm
       }
     }
   }
-  if (sequenceFile->isComplete() && composition != nullptr) {
-    if (reader != nullptr) {
-      reader = nullptr;
-      if (composition.use_count() != 1) {
-        container->addLayer(composition);
-      }
-    } else if (composition.use_count() <= 2) {
-      container->removeAllLayers();
-    }
-  }
+  checkSequenceComplete(composition);
   if (success) {
     lastReadIndex = index;
   }
   return success;
 }
 
+bool PAGDecoder::readFrames(int startIndex, int endIndex, const FrameCallback& callback,
+                            ColorType colorType, AlphaType alphaType, int maxThreads) {
+  std::lock_guard<std::mutex> auoLock(locker);
+  if (callback == nullptr) {
+    LOGE("PAGDecoder::readFrames() The specified callback is invalid!");
+    return false;
+  }
+  auto composition = getComposition();
+  checkCompositionChange(composition);
+  if (startIndex < 0 || endIndex > _numFrames || startIndex >= endIndex) {
+    LOGE("PAGDecoder::readFrames() The range is out of range!");
+    return false;
+  }
+  // Keep the rowBytes of previous readFrame() calls, the sequence file requires the same ImageInfo.
+  auto rowBytes = sequenceFile != nullptr ? lastImageInfo->rowBytes() : 0;
+  auto info =
+      tgfx::ImageInfo::Make(_width, _height, ToTGFX(colorType), ToTGFX(alphaType), rowBytes);
+  if (!checkSequenceFile(composition, info)) {
+    return false;
+  }
+  auto frameCount = endIndex - startIndex;
+  auto shardCount = GetShardCount(maxThreads, frameCount);
+  // Only an unmodified PAGFile can be copied for other threads, and there is nothing to render if
+  // the sequence file is already complete.
+  if (composition == nullptr || !composition->isPAGFile() ||
+      ContentVersion::Get(composition) > 0 || sequenceFile->isComplete()) {
+    shardCount = 1;
+  }
+  std::vector<std::unique_ptr<FrameShard>> shards = {};
+  for (int i = 0; i < shardCount; i++) {
+    auto shardStart = startIndex + frameCount * i / shardCount;
+    auto shardEnd = startIndex + frameCount * (i + 1) / shardCount;
+    shards.push_back(std::make_unique<FrameShard>(shardStart, shardEnd, info));
+  }
+  for (size_t i = 1; i < shards.size(); i++) {
+    auto shard = shards[i].get();
+    auto pagFile = std::static_pointer_cast<PAGFile>(composition)->copyOriginal();
+    shard->task = tgfx::Task::Run([shard, pagFile, file = sequenceFile, width = _width,
+                                   height = _height, numFrames = _numFrames, &callback]() {
+      std::shared_ptr<CompositionReader> shardReader = nullptr;
+      auto renderFrame = [&](int index) {
+        if (shardReader == nullptr) {
+          shardReader = CompositionReader::Make(width, height);
+          if (shardReader == nullptr) {
+            LOGE("PAGDecoder::readFrames() Failed to create a CompositionReader!");
+            return false;
+          }
+          shardReader->setComposition(pagFile);
+        }
+        auto progress = FrameToProgress(static_cast<Frame>(index), numFrames);
+        return shardReader->readFrame(progress, shard->bitmap);
+      };
+      shard->success = ReadFrameRange(file.get(), shard, renderFrame, callback);
+    });
+  }
+  // Read the first shard on the current thread with our own reader while waiting for others.
+  auto firstShard = shards[0].get();
+  firstShard->success = ReadFrameRange(
+      sequenceFile.get(), firstShard,
+      [&](int index) { return renderFrame(composition, index, firstShard->bitmap); }, callback);
+  auto success = true;
+  for (auto& shard : shards) {
+    if (shard->task != nullptr) {
+      shard->task->wait();
+    }
+    success = success && shard->success;
+  }
+  checkSequenceComplete(composition);
+  return success;
+}
+
+void PAGDecoder::checkSequenceComplete(const std::shared_ptr<PAGComposition>& composition) {
+  if (!sequenceFile->isComplete() || composition == nullptr) {
+    return;
+  }
+  if (reader != nullptr) {
+    reader = nullptr;
+    if (composition.use_count() != 1) {
+      container->addLayer(composition);
+    }
+  } else if (composition.use_count() <= 2) {
+    container->removeAllLayers();
+  }
+}
+
 bool PAGDecoder::renderFrame(std::shared_ptr<PAGComposition> composition, int index,
                              std::shared_ptr<BitmapBuffer> bitmap) {
   if (composition == nullptr) {
@@ -133,6 +133,56 @@ void PAGPlayer::setUseDiskCache(bool value) {
   renderCache->setUseDiskCache(value);
 }
 
+int PAGPlayer::maxPrefetchFrames() {
+  LockGuard autoLock(rootLocker);
+  return static_cast<int>(renderCache->maxPrefetchFrames());
+}
+
+void PAGPlayer::setMaxPrefetchFrames(int value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setMaxPrefetchFrames(value > 1 ? static_cast<size_t>(value) : 1);
+}
+
+size_t PAGPlayer::prefetchMemoryLimit() {
+  LockGuard autoLock(rootLocker);
+  return renderCache->prefetchMemoryLimit();
+}
+
+void PAGPlayer::setPrefetchMemoryLimit(size_t value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setPrefetchMemoryLimit(value);
+}
+
+int64_t PAGPlayer::prefetchWindow() {
+  LockGuard autoLock(rootLocker);
+  return renderCache->prefetchWindow();
+}
+
+void PAGPlayer::setPrefetchWindow(int64_t value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setPrefetchWindow(value > 0 ? value : 0);
+}
+
+int PAGPlayer::maxConcurrentPrefetches() {
+  LockGuard autoLock(rootLocker);
+  return static_cast<int>(renderCache->maxConcurrentPrefetches());
+}
+
+void PAGPlayer::setMaxConcurrentPrefetches(int value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setMaxConcurrentPrefetches(value > 0 ? static_cast<size_t>(value) : 0);
+}
+
+bool PAGPlayer::parallelPrepareEnabled() {
+  LockGuard autoLock(rootLocker);
+  return renderCache->parallelPrepareEnabled();
+}
+
+void PAGPlayer::setParallelPrepareEnabled(bool value) {
+  LockGuard autoLock(rootLocker);
+  renderCache->setParallelPrepareEnabled(value);
+}
+
 float PAGPlayer::cacheScale() {
   LockGuard autoLock(rootLocker);
   return stage->cacheScale();
@@ -271,6 +321,7 @@ void PAGPlayer::prepareInternal() {
   auto result = updateStageSize();
   if (result && contentVersion != stage->getContentVersion()) {
     contentVersion = stage->getContentVersion();
+    renderCache->prepareVisibleLayers();
     Recorder recorder = {};
     stage->draw(&recorder);
     lastGraphic = recorder.makeGraphic();
@@ -19,9 +19,11 @@
 #include "base/utils/TGFXCast.h"
 #include "pag/file.h"
 #include "pag/pag.h"
+#include "rendering/caches/ImageContentCache.h"
 #include "rendering/caches/RenderCache.h"
 #include "rendering/drawables/Drawable.h"
 #include "rendering/graphics/Recorder.h"
+#include "rendering/utils/FrameBufferPool.h"
 #include "rendering/utils/GLRestorer.h"
 #include "rendering/utils/LockGuard.h"
 #include "rendering/utils/shaper/TextShaper.h"
@@ -61,6 +63,8 @@ void PAGSurface::freeCache() {
 
 void PAGSurface::onFreeCache() {
   TextShaper::PurgeCaches();
+  ImageContentCache::PurgeUnusedImages();
+  FrameBufferPool::Get()->purge();
   if (pagPlayer) {
     pagPlayer->renderCache->releaseAll();
   }
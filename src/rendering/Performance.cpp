@@ -24,13 +24,14 @@ std::string Performance::getPerformanceString() const {
   char buffer[300];
   snprintf(buffer, 300,
            "%6.1fms[Render] %6.1fms[Image] %6.1fms[Video]"
-           " %6.1fms[Texture] %6.1fms[Program] %6.1fms[Present] ",
+           " %6.1fms[Texture] %6.1fms[Program] %6.1fms[Present] %6lld[FrameCaches] ",
            static_cast<double>(renderingTime) / 1000.0,
            static_cast<double>(imageDecodingTime) / 1000.0,
            static_cast<double>(softwareDecodingTime + hardwareDecodingTime) / 1000.0,
            static_cast<double>(textureUploadingTime) / 1000.0,
            static_cast<double>(programCompilingTime) / 1000.0,
-           static_cast<double>(presentingTime) / 1000.0);
+           static_cast<double>(presentingTime) / 1000.0,
+           static_cast<long long>(frameCacheCount));
   return buffer;
 }
 
@@ -52,5 +53,6 @@ void Performance::resetPerformance() {
   hardwareDecodingInitialTime = 0;
   softwareDecodingInitialTime = 0;
   totalTime = 0;
+  frameCacheCount = 0;
 }
 }  // namespace pag
\ No newline at end of file
@@ -39,6 +39,8 @@ class Performance {
   int64_t hardwareDecodingInitialTime = 0;
   int64_t softwareDecodingInitialTime = 0;
   int64_t totalTime = 0;
+  // The number of frames cached by all FrameCaches in the process.
+  int64_t frameCacheCount = 0;
 
   /**
    * Returns the formatted  string which contains the performance data.
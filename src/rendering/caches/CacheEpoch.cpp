@@ -0,0 +1,58 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "CacheEpoch.h"
+
+namespace pag {
+// The threads can only be in the current epoch or the previous one, so three counters are enough.
+static constexpr uint64_t EPOCH_SLOT_COUNT = 3;
+
+static std::atomic<uint64_t> globalEpoch = 0;
+static std::atomic<int64_t> activeThreads[EPOCH_SLOT_COUNT] = {};
+
+uint64_t CacheEpoch::Enter() {
+  while (true) {
+    auto epoch = globalEpoch.load(std::memory_order_acquire);
+    activeThreads[epoch % EPOCH_SLOT_COUNT].fetch_add(1, std::memory_order_seq_cst);
+    if (globalEpoch.load(std::memory_order_seq_cst) == epoch) {
+      return epoch;
+    }
+    // The epoch was advanced before we were counted in, tries again with the new one.
+    activeThreads[epoch % EPOCH_SLOT_COUNT].fetch_sub(1, std::memory_order_release);
+  }
+}
+
+void CacheEpoch::Exit(uint64_t epoch) {
+  activeThreads[epoch % EPOCH_SLOT_COUNT].fetch_sub(1, std::memory_order_release);
+}
+
+uint64_t CacheEpoch::Current() {
+  return globalEpoch.load(std::memory_order_acquire);
+}
+
+bool CacheEpoch::IsReclaimable(uint64_t retiredEpoch) {
+  auto epoch = globalEpoch.load(std::memory_order_acquire);
+  // The epoch can only be advanced when no thread remains in the previous one.
+  if (epoch == 0 || activeThreads[(epoch - 1) % EPOCH_SLOT_COUNT].load() == 0) {
+    globalEpoch.compare_exchange_strong(epoch, epoch + 1);
+  }
+  // An object retired in epoch N may be used by threads in epoch N and N - 1, all of them have
+  // exited once the epoch reaches N + 2.
+  return globalEpoch.load(std::memory_order_acquire) >= retiredEpoch + 2;
+}
+}  // namespace pag
@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace pag {
+/**
+ * CacheEpoch implements epoch-based reclamation for the caches shared by multiple threads. A
+ * thread accessing the caches stays in the current epoch between Enter() and Exit(), and the
+ * objects removed from the caches are retired instead of being deleted immediately. A retired
+ * object can be safely deleted once IsReclaimable() returns true for the epoch when it was retired,
+ * since no thread can still be using it.
+ */
+class CacheEpoch {
+ public:
+  /**
+   * Enters the current epoch, returns the epoch to pass to Exit().
+   */
+  static uint64_t Enter();
+
+  /**
+   * Exits the epoch returned by Enter().
+   */
+  static void Exit(uint64_t epoch);
+
+  /**
+   * Returns the current epoch, which is used to tag the objects being retired.
+   */
+  static uint64_t Current();
+
+  /**
+   * Returns true if the objects retired in the specified epoch can be deleted. It also tries to
+   * advance the current epoch.
+   */
+  static bool IsReclaimable(uint64_t retiredEpoch);
+};
+
+/**
+ * Keeps the current thread in the current epoch during its lifetime.
+ */
+class EpochGuard {
+ public:
+  EpochGuard() : epoch(CacheEpoch::Enter()) {
+  }
+
+  ~EpochGuard() {
+    CacheEpoch::Exit(epoch);
+  }
+
+ private:
+  uint64_t epoch = 0;
+};
+}  // namespace pag
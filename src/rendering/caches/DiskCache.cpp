@@ -17,14 +17,31 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "DiskCache.h"
+#include <algorithm>
 #include "pag/pag.h"
 #include "platform/Platform.h"
 #include "rendering/utils/Directory.h"
 #include "tgfx/core/Buffer.h"
 #include "tgfx/core/DataView.h"
 #include "tgfx/core/Stream.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
+/**
+ * The cache.cfg file is a snapshot of the cached files in LRU order, and all changes made after
+ * the snapshot are appended to the cache.journal file as records:
+ * [op: uint8_t]
+ * [fileID: uint32_t]
+ * [keyLength: uint32_t]
+ * [key: keyLength bytes]
+ * The journal is compacted into a new snapshot on a background thread once it grows too large.
+ */
+static constexpr uint8_t JOURNAL_ADD = 1;
+static constexpr uint8_t JOURNAL_REMOVE = 2;
+static constexpr size_t JOURNAL_RECORD_HEAD_SIZE = 9;
+static constexpr size_t MAX_JOURNAL_SIZE = 64 * 1024;
+static constexpr size_t SHARD_COUNT = 16;
+
 class FileInfo {
  public:
   FileInfo(std::string cacheKey, uint32_t fileID, size_t fileSize = 0)
@@ -34,6 +51,7 @@ class FileInfo {
   std::string cacheKey;
   uint32_t fileID = 0;
   size_t fileSize = 0;
+  uint64_t lastAccess = 0;
   std::list<std::shared_ptr<FileInfo>>::iterator cachedPosition;
 };
 
@@ -45,6 +63,22 @@ void PAGDiskCache::SetMaxDiskSize(size_t size) {
   DiskCache::GetInstance()->setMaxDiskSize(size);
 }
 
+bool PAGDiskCache::CompressionEnabled() {
+  return DiskCache::GetInstance()->getCompressionEnabled();
+}
+
+void PAGDiskCache::SetCompressionEnabled(bool value) {
+  DiskCache::GetInstance()->setCompressionEnabled(value);
+}
+
+bool PAGDiskCache::DeltaCompressionEnabled() {
+  return DiskCache::GetInstance()->getDeltaCompressionEnabled();
+}
+
+void PAGDiskCache::SetDeltaCompressionEnabled(bool value) {
+  DiskCache::GetInstance()->setDeltaCompressionEnabled(value);
+}
+
 void PAGDiskCache::RemoveAll() {
   DiskCache::GetInstance()->removeAll();
 }
@@ -68,10 +102,16 @@ bool DiskCache::WriteFile(const std::string& key, std::shared_ptr<tgfx::Data> da
   return GetInstance()->writeFile(key, data);
 }
 
-DiskCache::DiskCache() {
-  auto cacheDir = Platform::Current()->getCacheDir();
+DiskCache::DiskCache() : DiskCache(Platform::Current()->getCacheDir()) {
+}
+
+DiskCache::DiskCache(const std::string& cacheDir) {
+  for (size_t i = 0; i < SHARD_COUNT; i++) {
+    shards.push_back(std::make_unique<DiskCacheShard>());
+  }
   if (!cacheDir.empty()) {
     configPath = Directory::JoinPath(cacheDir, "cache.cfg");
+    journalPath = Directory::JoinPath(cacheDir, "cache.journal");
     cacheFolder = Directory::JoinPath(cacheDir, "files");
     if (!readConfig()) {
       Directory::VisitFiles(cacheFolder,
@@ -80,91 +120,159 @@ DiskCache::DiskCache() {
   }
 }
 
+DiskCache::~DiskCache() {
+  // The background tasks capture this instance, waits for them to finish before releasing it.
+  waitForEviction();
+  while (true) {
+    std::shared_ptr<tgfx::Task> task = nullptr;
+    {
+      std::lock_guard<std::mutex> autoLock(journalLocker);
+      task = std::move(flushTask);
+    }
+    if (task == nullptr) {
+      break;
+    }
+    task->wait();
+  }
+  std::lock_guard<std::mutex> autoLock(configLocker);
+}
+
 size_t DiskCache::getMaxDiskSize() {
-  std::lock_guard<std::mutex> autoLock(locker);
   return maxDiskSize;
 }
 
 void DiskCache::setMaxDiskSize(size_t size) {
-  std::lock_guard<std::mutex> autoLock(locker);
-  if (maxDiskSize == size) {
+  if (maxDiskSize.exchange(size) == size) {
     return;
   }
-  maxDiskSize = size;
-  if (checkDiskSpace(maxDiskSize)) {
-    saveConfig();
-  }
+  checkDiskSpace(size);
+}
+
+bool DiskCache::getCompressionEnabled() {
+  return compressionEnabled;
+}
+
+void DiskCache::setCompressionEnabled(bool value) {
+  compressionEnabled = value;
+}
+
+bool DiskCache::getDeltaCompressionEnabled() {
+  return deltaCompressionEnabled;
+}
+
+void DiskCache::setDeltaCompressionEnabled(bool value) {
+  deltaCompressionEnabled = value;
 }
 
 void DiskCache::removeAll() {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty()) {
     return;
   }
+  std::lock_guard<std::mutex> evictionLock(evictionLocker);
+  // Locks all shards in order, so no file can be added while removing.
+  std::vector<std::unique_lock<std::mutex>> locks = {};
+  for (auto& shard : shards) {
+    locks.emplace_back(shard->locker);
+  }
   Directory::VisitFiles(cacheFolder, [&](const std::string& path, size_t) {
     auto fileID = filePathToID(path);
-    if (openedFiles.count(fileID) > 0) {
-      return;
+    for (auto& shard : shards) {
+      if (shard->openedFiles.count(fileID) > 0) {
+        return;
+      }
     }
     remove(path.c_str());
   });
-  cachedFileIDs.clear();
-  cachedFiles.clear();
-  cachedFileInfos.clear();
+  for (auto& shard : shards) {
+    shard->cachedFileIDs.clear();
+    shard->cachedFiles.clear();
+    shard->cachedFileInfos.clear();
+  }
   totalDiskSize = 0;
-  saveConfig();
+  requestCompaction();
   LOGI("DiskCache::removeAll() all cached files have been removed!");
 }
 
 std::shared_ptr<SequenceFile> DiskCache::openSequence(
     const std::string& key, const tgfx::ImageInfo& info, int frameCount, float frameRate,
     const std::vector<TimeRange>& staticTimeRanges) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty()) {
     return nullptr;
   }
-  auto fileID = getFileID(key);
-  auto result = openedFiles.find(fileID);
-  if (result != openedFiles.end()) {
-    auto sequenceFile = result->second.lock();
-    if (sequenceFile != nullptr) {
-      if (sequenceFile->compatible(info, frameCount, frameRate, staticTimeRanges)) {
-        moveToFront(cachedFileInfos[fileID]);
-        return sequenceFile;
+  uint32_t fileID = 0;
+  DiskCacheShard* shard = nullptr;
+  if (key.empty()) {
+    fileID = fileIDCount++;
+    shard = getShard(fileID);
+  } else {
+    shard = getShard(key);
+  }
+  std::shared_ptr<SequenceFile> sequenceFile = nullptr;
+  // Declared outside the lock, so releasing the last reference to it never reenters the lock.
+  std::shared_ptr<SequenceFile> openedFile = nullptr;
+  {
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    if (!key.empty()) {
+      fileID = getFileID(shard, key);
+      auto result = shard->openedFiles.find(fileID);
+      if (result != shard->openedFiles.end()) {
+        openedFile = result->second.lock();
+        if (openedFile != nullptr) {
+          if (openedFile->compatible(info, frameCount, frameRate, staticTimeRanges)) {
+            auto fileInfo = shard->cachedFileInfos.find(fileID);
+            if (fileInfo != shard->cachedFileInfos.end()) {
+              moveToFront(shard, fileInfo->second);
+            }
+            return openedFile;
+          }
+          changeToTemporary(shard, fileID);
+          fileID = getFileID(shard, key);
+        }
       }
-      changeToTemporary(fileID);
-      fileID = getFileID(key);
     }
-  }
-  auto filePath = fileIDToPath(fileID);
-  auto sequenceFile = SequenceFile::Open(filePath, info, frameCount, frameRate, staticTimeRanges);
-  if (sequenceFile == nullptr) {
-    return nullptr;
-  }
-  sequenceFile->diskCache = this;
-  sequenceFile->fileID = fileID;
-  openedFiles[fileID] = sequenceFile;
-  if (!key.empty()) {
-    auto oldFileInfo = cachedFileInfos[fileID];
-    if (oldFileInfo) {
-      auto fileSize = sequenceFile->fileSize();
-      totalDiskSize += fileSize - oldFileInfo->fileSize;
-      oldFileInfo->fileSize = fileSize;
-      moveToFront(oldFileInfo);
-    } else {
-      addToCachedFiles(std::make_shared<FileInfo>(key, fileID, 0));
-      saveConfig();
+    auto filePath = fileIDToPath(fileID);
+    auto compressionType = DEFAULT_COMPRESSION_TYPE;
+    if (!compressionEnabled) {
+      compressionType = CompressionType::None;
+    } else if (deltaCompressionEnabled) {
+      compressionType = CompressionType::LZ4_DELTA;
+    }
+    sequenceFile = SequenceFile::Open(filePath, info, frameCount, frameRate, staticTimeRanges,
+                                      compressionType);
+    if (sequenceFile == nullptr) {
+      return nullptr;
     }
+    sequenceFile->diskCache = this;
+    sequenceFile->diskCacheShard = shard;
+    sequenceFile->fileID = fileID;
+    shard->openedFiles[fileID] = sequenceFile;
+    if (!key.empty()) {
+      auto result = shard->cachedFileInfos.find(fileID);
+      if (result != shard->cachedFileInfos.end()) {
+        auto oldFileInfo = result->second;
+        auto fileSize = sequenceFile->fileSize();
+        totalDiskSize += fileSize - oldFileInfo->fileSize;
+        oldFileInfo->fileSize = fileSize;
+        moveToFront(shard, oldFileInfo);
+      } else {
+        addToCachedFiles(shard, std::make_shared<FileInfo>(key, fileID, 0));
+        appendJournal(JOURNAL_ADD, fileID, key);
+      }
+    }
+  }
+  if (totalDiskSize > maxDiskSize) {
+    scheduleEviction();
   }
   return sequenceFile;
 }
 
 std::shared_ptr<tgfx::Data> DiskCache::readFile(const std::string& key) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty() || key.empty()) {
     return nullptr;
   }
-  auto fileID = getFileID(key);
+  auto shard = getShard(key);
+  std::lock_guard<std::mutex> autoLock(shard->locker);
+  auto fileID = getFileID(shard, key);
   auto filePath = fileIDToPath(fileID);
   auto stream = tgfx::Stream::MakeFromFile(filePath);
   if (stream == nullptr) {
@@ -179,18 +287,16 @@ std::shared_ptr<tgfx::Data> DiskCache::readFile(const std::string& key) {
 }
 
 bool DiskCache::writeFile(const std::string& key, std::shared_ptr<tgfx::Data> data) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (cacheFolder.empty() || key.empty() || data == nullptr) {
     return false;
   }
-  auto changed = checkDiskSpace(maxDiskSize - data->size());
+  checkDiskSpace(maxDiskSize - data->size());
   if (totalDiskSize + data->size() > maxDiskSize) {
-    if (changed) {
-      saveConfig();
-    }
     return false;
   }
-  auto fileID = getFileID(key);
+  auto shard = getShard(key);
+  std::lock_guard<std::mutex> autoLock(shard->locker);
+  auto fileID = getFileID(shard, key);
   auto filePath = fileIDToPath(fileID);
   Directory::CreateRecursively(Directory::GetParentDirectory(filePath));
   auto file = fopen(filePath.c_str(), "wb");
@@ -203,63 +309,159 @@ bool DiskCache::writeFile(const std::string& key, std::shared_ptr<tgfx::Data> da
     return false;
   }
   totalDiskSize += data->size();
-  auto fileInfo = cachedFileInfos[fileID];
-  if (fileInfo) {
+  std::shared_ptr<FileInfo> fileInfo = nullptr;
+  auto result = shard->cachedFileInfos.find(fileID);
+  if (result != shard->cachedFileInfos.end()) {
+    fileInfo = result->second;
     totalDiskSize -= fileInfo->fileSize;
     fileInfo->fileSize = data->size();
   } else {
-    addToCachedFiles(std::make_shared<FileInfo>(key, fileID, data->size()));
-    fileInfo = cachedFileInfos[fileID];
-    changed = true;
-  }
-  moveToBeforeOpenedFiles(fileInfo);
-  if (changed) {
-    saveConfig();
+    fileInfo = std::make_shared<FileInfo>(key, fileID, data->size());
+    addToCachedFiles(shard, fileInfo);
+    appendJournal(JOURNAL_ADD, fileID, key);
   }
+  moveToBeforeOpenedFiles(shard, fileInfo);
   return true;
 }
 
+DiskCacheShard* DiskCache::getShard(const std::string& key) {
+  return shards[std::hash<std::string>()(key) % shards.size()].get();
+}
+
+DiskCacheShard* DiskCache::getShard(uint32_t fileID) {
+  return shards[fileID % shards.size()].get();
+}
+
+std::shared_ptr<FileInfo> DiskCache::findFileInfo(uint32_t fileID, DiskCacheShard** shard) {
+  for (auto& item : shards) {
+    auto result = item->cachedFileInfos.find(fileID);
+    if (result != item->cachedFileInfos.end()) {
+      *shard = item.get();
+      return result->second;
+    }
+  }
+  return nullptr;
+}
+
+size_t DiskCache::openedFileCount() {
+  size_t count = 0;
+  for (auto& shard : shards) {
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    count += shard->openedFiles.size();
+  }
+  return count;
+}
+
+size_t DiskCache::cachedFileCount() {
+  size_t count = 0;
+  for (auto& shard : shards) {
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    count += shard->cachedFiles.size();
+  }
+  return count;
+}
+
 bool DiskCache::checkDiskSpace(size_t maxSize) {
+  std::lock_guard<std::mutex> autoLock(evictionLocker);
   bool changed = false;
   if (totalDiskSize <= maxSize) {
     return changed;
   }
   LOGE("Cached data exceeds threshold, current threshold is:%lld !!! \n", maxSize);
-  while (totalDiskSize > maxSize) {
-    auto fileInfo = cachedFiles.back();
-    if (openedFiles.count(fileInfo->fileID) > 0) {
-      break;
-    }
-    auto filePath = fileIDToPath(fileInfo->fileID);
-    remove(filePath.c_str());
-    totalDiskSize -= fileInfo->fileSize;
-    removeFromCachedFiles(fileInfo);
+  while (totalDiskSize > maxSize && evictOldestFile()) {
     changed = true;
   }
   return changed;
 }
 
-void DiskCache::addToCachedFiles(std::shared_ptr<FileInfo> fileInfo) {
-  cachedFiles.push_front(fileInfo);
-  fileInfo->cachedPosition = cachedFiles.begin();
-  cachedFileInfos[fileInfo->fileID] = fileInfo;
+bool DiskCache::evictOldestFile() {
+  // Every shard is an independent LRU list, the least recently used file that is not opened in
+  // all shards is evicted.
+  DiskCacheShard* victimShard = nullptr;
+  std::shared_ptr<FileInfo> victim = nullptr;
+  // The access time is written under the lock of its own shard, so it is copied while holding it.
+  uint64_t victimAccess = 0;
+  for (auto& shard : shards) {
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    if (shard->cachedFiles.empty()) {
+      continue;
+    }
+    auto& fileInfo = shard->cachedFiles.back();
+    if (shard->openedFiles.count(fileInfo->fileID) > 0) {
+      continue;
+    }
+    if (victim == nullptr || fileInfo->lastAccess < victimAccess) {
+      victim = fileInfo;
+      victimShard = shard.get();
+      victimAccess = fileInfo->lastAccess;
+    }
+  }
+  if (victim == nullptr) {
+    return false;
+  }
+  std::lock_guard<std::mutex> autoLock(victimShard->locker);
+  // The file may have been reopened, accessed or removed after the scan, then tries again.
+  if (victimShard->cachedFiles.empty() || victimShard->cachedFiles.back() != victim ||
+      victim->lastAccess != victimAccess || victimShard->openedFiles.count(victim->fileID) > 0) {
+    return true;
+  }
+  auto filePath = fileIDToPath(victim->fileID);
+  remove(filePath.c_str());
+  totalDiskSize -= victim->fileSize;
+  removeFromCachedFiles(victimShard, victim);
+  appendJournal(JOURNAL_REMOVE, victim->fileID);
+  return true;
 }
 
-void DiskCache::removeFromCachedFiles(std::shared_ptr<FileInfo> fileInfo) {
-  cachedFiles.erase(fileInfo->cachedPosition);
-  cachedFileInfos.erase(fileInfo->fileID);
+void DiskCache::scheduleEviction() {
+  if (evictionScheduled.exchange(true)) {
+    return;
+  }
+  std::lock_guard<std::mutex> autoLock(evictionTaskLocker);
+  // The destructor waits for the task, so it is safe to capture this instance.
+  evictionTask = tgfx::Task::Run([this]() {
+    evictionScheduled = false;
+    checkDiskSpace(maxDiskSize);
+  });
 }
 
-void DiskCache::moveToFront(std::shared_ptr<FileInfo> fileInfo) {
-  cachedFiles.erase(fileInfo->cachedPosition);
-  cachedFiles.push_front(fileInfo);
-  fileInfo->cachedPosition = cachedFiles.begin();
+void DiskCache::waitForEviction() {
+  std::shared_ptr<tgfx::Task> task = nullptr;
+  {
+    std::lock_guard<std::mutex> autoLock(evictionTaskLocker);
+    task = evictionTask;
+  }
+  if (task != nullptr) {
+    task->wait();
+  }
+}
+
+void DiskCache::addToCachedFiles(DiskCacheShard* shard, std::shared_ptr<FileInfo> fileInfo) {
+  fileInfo->lastAccess = ++accessClock;
+  shard->cachedFiles.push_front(fileInfo);
+  fileInfo->cachedPosition = shard->cachedFiles.begin();
+  shard->cachedFileInfos[fileInfo->fileID] = fileInfo;
+}
+
+void DiskCache::removeFromCachedFiles(DiskCacheShard* shard, std::shared_ptr<FileInfo> fileInfo) {
+  shard->cachedFiles.erase(fileInfo->cachedPosition);
+  shard->cachedFileInfos.erase(fileInfo->fileID);
+}
+
+void DiskCache::moveToFront(DiskCacheShard* shard, std::shared_ptr<FileInfo> fileInfo) {
+  fileInfo->lastAccess = ++accessClock;
+  shard->cachedFiles.erase(fileInfo->cachedPosition);
+  shard->cachedFiles.push_front(fileInfo);
+  fileInfo->cachedPosition = shard->cachedFiles.begin();
 }
 
-void DiskCache::moveToBeforeOpenedFiles(std::shared_ptr<FileInfo> fileInfo) {
+void DiskCache::moveToBeforeOpenedFiles(DiskCacheShard* shard,
+                                        std::shared_ptr<FileInfo> fileInfo) {
+  fileInfo->lastAccess = ++accessClock;
+  auto& cachedFiles = shard->cachedFiles;
   cachedFiles.erase(fileInfo->cachedPosition);
   for (auto it = cachedFiles.begin(); it != cachedFiles.end(); ++it) {
-    if (openedFiles.count((*it)->fileID) == 0) {
+    if (shard->openedFiles.count((*it)->fileID) == 0) {
       fileInfo->cachedPosition = cachedFiles.insert(it, fileInfo);
       fileInfo = nullptr;
       break;
@@ -272,13 +474,50 @@ void DiskCache::moveToBeforeOpenedFiles(std::shared_ptr<FileInfo> fileInfo) {
 }
 
 bool DiskCache::readConfig() {
+  auto hasSnapshot = readSnapshot();
+  auto hasJournal = replayJournal();
+  if (!hasSnapshot && !hasJournal) {
+    return false;
+  }
+  Directory::VisitFiles(cacheFolder, [&](const std::string& path, size_t fileSize) {
+    DiskCacheShard* shard = nullptr;
+    auto fileInfo = findFileInfo(filePathToID(path), &shard);
+    if (fileInfo == nullptr) {
+      remove(path.c_str());
+    } else {
+      fileInfo->fileSize = fileSize;
+    }
+  });
+  bool expired = false;
+  for (auto& shard : shards) {
+    std::vector<std::shared_ptr<FileInfo>> expiredFiles = {};
+    for (auto& item : shard->cachedFiles) {
+      if (item->fileSize > 0) {
+        totalDiskSize += item->fileSize;
+      } else {
+        expiredFiles.push_back(item);
+      }
+    }
+    for (auto& item : expiredFiles) {
+      removeFromCachedFiles(shard.get(), item);
+    }
+    expired = expired || !expiredFiles.empty();
+  }
+  checkDiskSpace(maxDiskSize);
+  if (hasJournal || expired) {
+    requestCompaction();
+  }
+  return true;
+}
+
+bool DiskCache::readSnapshot() {
   auto file = fopen(configPath.c_str(), "rb");
   if (file == nullptr) {
     return false;
   }
   fseek(file, 0, SEEK_END);
   auto size = ftell(file);
-  if (size == 0) {
+  if (size <= 0) {
     fclose(file);
     return false;
   }
@@ -297,51 +536,173 @@ bool DiskCache::readConfig() {
     }
     auto cacheKey = std::string(reinterpret_cast<const char*>(dataView.bytes()) + pos, keyLength);
     pos += keyLength;
-    fileIDCount = std::max(fileIDCount, fileID + 1);
-    addToCachedFiles(std::make_shared<FileInfo>(cacheKey, fileID, 0));
-    cachedFileIDs[cacheKey] = fileID;
+    if (fileIDCount <= fileID) {
+      fileIDCount = fileID + 1;
+    }
+    auto shard = getShard(cacheKey);
+    addToCachedFiles(shard, std::make_shared<FileInfo>(cacheKey, fileID, 0));
+    shard->cachedFileIDs[cacheKey] = fileID;
   }
-  Directory::VisitFiles(cacheFolder, [&](const std::string& path, size_t fileSize) {
-    auto fileID = filePathToID(path);
-    auto result = cachedFileInfos.find(fileID);
-    if (result == cachedFileInfos.end()) {
-      remove(path.c_str());
-    } else {
-      result->second->fileSize = fileSize;
+  return true;
+}
+
+bool DiskCache::replayJournal() {
+  auto file = fopen(journalPath.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  auto size = ftell(file);
+  if (size <= 0) {
+    fclose(file);
+    return false;
+  }
+  fseek(file, 0, SEEK_SET);
+  tgfx::Buffer buffer(size);
+  auto length = fread(buffer.data(), 1, size, file);
+  fclose(file);
+  tgfx::DataView dataView(buffer.bytes(), length);
+  size_t pos = 0;
+  // A record cut off by a crash is ignored, together with everything after it.
+  while (pos + JOURNAL_RECORD_HEAD_SIZE <= dataView.size()) {
+    auto op = dataView.getUint8(pos);
+    auto fileID = dataView.getUint32(pos + 1);
+    auto keyLength = dataView.getUint32(pos + 5);
+    pos += JOURNAL_RECORD_HEAD_SIZE;
+    if (pos + keyLength > dataView.size()) {
+      break;
     }
-  });
-  std::vector<std::shared_ptr<FileInfo>> expiredFiles = {};
-  for (auto& item : cachedFiles) {
-    if (item->fileSize > 0) {
-      totalDiskSize += item->fileSize;
-    } else {
-      expiredFiles.push_back(item);
+    auto cacheKey = std::string(reinterpret_cast<const char*>(dataView.bytes()) + pos, keyLength);
+    pos += keyLength;
+    DiskCacheShard* shard = nullptr;
+    auto fileInfo = findFileInfo(fileID, &shard);
+    if (fileInfo != nullptr) {
+      shard->cachedFileIDs.erase(fileInfo->cacheKey);
+      removeFromCachedFiles(shard, fileInfo);
+    }
+    if (op == JOURNAL_ADD) {
+      if (fileIDCount <= fileID) {
+        fileIDCount = fileID + 1;
+      }
+      shard = getShard(cacheKey);
+      addToCachedFiles(shard, std::make_shared<FileInfo>(cacheKey, fileID, 0));
+      shard->cachedFileIDs[cacheKey] = fileID;
+    } else if (op != JOURNAL_REMOVE) {
+      break;
     }
   }
-  for (auto& item : expiredFiles) {
-    removeFromCachedFiles(item);
+  return true;
+}
+
+void DiskCache::appendJournal(uint8_t op, uint32_t fileID, const std::string& cacheKey) {
+  if (journalPath.empty()) {
+    return;
   }
-  if (checkDiskSpace(maxDiskSize) || !expiredFiles.empty()) {
-    saveConfig();
+  std::lock_guard<std::mutex> autoLock(journalLocker);
+  auto pos = pendingJournal.size();
+  auto recordSize = JOURNAL_RECORD_HEAD_SIZE + cacheKey.size();
+  pendingJournal.resize(pos + recordSize);
+  tgfx::DataView dataView(pendingJournal.data() + pos, recordSize);
+  dataView.setUint8(0, op);
+  dataView.setUint32(1, fileID);
+  dataView.setUint32(5, static_cast<uint32_t>(cacheKey.size()));
+  memcpy(dataView.writableBytes() + JOURNAL_RECORD_HEAD_SIZE, cacheKey.data(), cacheKey.size());
+  scheduleConfigFlush();
+}
+
+void DiskCache::requestCompaction() {
+  if (configPath.empty()) {
+    return;
   }
-  return true;
+  std::lock_guard<std::mutex> autoLock(journalLocker);
+  compactionRequested = true;
+  scheduleConfigFlush();
+}
+
+void DiskCache::scheduleConfigFlush() {
+  if (flushScheduled) {
+    return;
+  }
+  flushScheduled = true;
+  // The destructor waits for the task, so it is safe to capture this instance.
+  flushTask = tgfx::Task::Run([this]() { flushConfig(); });
 }
 
-void DiskCache::saveConfig() {
+void DiskCache::flushConfig() {
+  std::lock_guard<std::mutex> configLock(configLocker);
+  std::vector<uint8_t> records = {};
+  bool compaction = false;
+  {
+    std::lock_guard<std::mutex> autoLock(journalLocker);
+    flushScheduled = false;
+    compaction = compactionRequested || journalSize + pendingJournal.size() > MAX_JOURNAL_SIZE;
+    if (compaction) {
+      // The snapshot taken below contains all the pending changes. Changes made after this point
+      // are also appended to the new journal, which is fine since replaying them is idempotent.
+      compactionRequested = false;
+      pendingJournal.clear();
+    } else {
+      records.swap(pendingJournal);
+    }
+  }
   Directory::CreateRecursively(Directory::GetParentDirectory(configPath));
-  auto file = fopen(configPath.c_str(), "wb");
+  if (compaction) {
+    auto snapshot = makeSnapshot();
+    // Writes the snapshot to a temporary file first, so a crash never leaves a broken snapshot.
+    auto tempPath = configPath + ".tmp";
+    auto file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+      return;
+    }
+    auto snapshotSize = snapshot != nullptr ? snapshot->size() : 0;
+    auto writeLength = snapshotSize > 0 ? fwrite(snapshot->data(), 1, snapshotSize, file) : 0;
+    fclose(file);
+    if (writeLength != snapshotSize) {
+      remove(tempPath.c_str());
+      return;
+    }
+#ifdef _WIN32
+    remove(configPath.c_str());
+#endif
+    if (rename(tempPath.c_str(), configPath.c_str()) != 0) {
+      remove(tempPath.c_str());
+      return;
+    }
+    remove(journalPath.c_str());
+    journalSize = 0;
+    return;
+  }
+  if (records.empty()) {
+    return;
+  }
+  auto file = fopen(journalPath.c_str(), "ab");
   if (file == nullptr) {
     return;
   }
+  journalSize += fwrite(records.data(), 1, records.size(), file);
+  fclose(file);
+}
+
+std::shared_ptr<tgfx::Data> DiskCache::makeSnapshot() {
+  std::vector<std::pair<uint64_t, std::shared_ptr<FileInfo>>> fileInfos = {};
+  for (auto& shard : shards) {
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    for (auto& item : shard->cachedFiles) {
+      fileInfos.emplace_back(item->lastAccess, item);
+    }
+  }
+  // The snapshot lists files from the least recently used to the most recently used.
+  std::sort(fileInfos.begin(), fileInfos.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
   size_t bufferSize = 0;
-  for (auto& item : cachedFiles) {
-    bufferSize += 8 + item->cacheKey.size();
+  for (auto& item : fileInfos) {
+    bufferSize += 8 + item.second->cacheKey.size();
   }
   tgfx::Buffer buffer(bufferSize);
   tgfx::DataView dataView(buffer.bytes(), buffer.size());
   size_t pos = 0;
-  for (auto item = cachedFiles.rbegin(); item != cachedFiles.rend(); item++) {
-    auto& fileInfo = *item;
+  for (auto& item : fileInfos) {
+    auto& fileInfo = item.second;
     auto& cacheKey = fileInfo->cacheKey;
     dataView.setUint32(pos, fileInfo->fileID);
     dataView.setUint32(pos + 4, static_cast<uint32_t>(cacheKey.size()));
@@ -349,33 +710,33 @@ void DiskCache::saveConfig() {
     memcpy(dataView.writableBytes() + pos, cacheKey.data(), cacheKey.size());
     pos += cacheKey.size();
   }
-  fwrite(buffer.data(), 1, bufferSize, file);
-  fclose(file);
+  return buffer.release();
 }
 
-uint32_t DiskCache::getFileID(const std::string& key) {
+uint32_t DiskCache::getFileID(DiskCacheShard* shard, const std::string& key) {
   if (key.empty()) {
     return fileIDCount++;
   }
-  auto result = cachedFileIDs.find(key);
-  if (result != cachedFileIDs.end()) {
+  auto result = shard->cachedFileIDs.find(key);
+  if (result != shard->cachedFileIDs.end()) {
     return result->second;
   }
   auto newFileID = fileIDCount++;
-  cachedFileIDs[key] = newFileID;
+  shard->cachedFileIDs[key] = newFileID;
   return newFileID;
 }
 
-void DiskCache::changeToTemporary(uint32_t fileID) {
-  auto result = cachedFileInfos.find(fileID);
-  if (result == cachedFileInfos.end()) {
+void DiskCache::changeToTemporary(DiskCacheShard* shard, uint32_t fileID) {
+  auto result = shard->cachedFileInfos.find(fileID);
+  if (result == shard->cachedFileInfos.end()) {
     return;
   }
   auto fileInfo = result->second;
-  cachedFiles.erase(fileInfo->cachedPosition);
-  cachedFileInfos.erase(fileID);
+  shard->cachedFiles.erase(fileInfo->cachedPosition);
+  shard->cachedFileInfos.erase(fileID);
   totalDiskSize -= fileInfo->fileSize;
-  cachedFileIDs.erase(fileInfo->cacheKey);
+  shard->cachedFileIDs.erase(fileInfo->cacheKey);
+  appendJournal(JOURNAL_REMOVE, fileID);
 }
 
 std::string DiskCache::fileIDToPath(uint32_t fileID) {
@@ -390,31 +751,35 @@ uint32_t DiskCache::filePathToID(const std::string& path) {
   return static_cast<uint32_t>(std::stoull(fileName));
 }
 
-void DiskCache::notifyFileClosed(uint32_t fileID) {
-  std::lock_guard<std::mutex> autoLock(locker);
-  openedFiles.erase(fileID);
-  auto result = cachedFileInfos.find(fileID);
-  if (result == cachedFileInfos.end()) {
-    auto filePath = fileIDToPath(fileID);
-    remove(filePath.c_str());
-  } else {
-    auto fileInfo = result->second;
-    moveToBeforeOpenedFiles(fileInfo);
-    if (checkDiskSpace(maxDiskSize)) {
-      saveConfig();
+void DiskCache::notifyFileClosed(DiskCacheShard* shard, uint32_t fileID) {
+  {
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    shard->openedFiles.erase(fileID);
+    auto result = shard->cachedFileInfos.find(fileID);
+    if (result == shard->cachedFileInfos.end()) {
+      auto filePath = fileIDToPath(fileID);
+      remove(filePath.c_str());
+      return;
     }
+    moveToBeforeOpenedFiles(shard, result->second);
+  }
+  if (totalDiskSize > maxDiskSize) {
+    scheduleEviction();
   }
 }
 
-void DiskCache::notifyFileSizeChanged(uint32_t fileID, size_t fileSize) {
-  std::lock_guard<std::mutex> autoLock(locker);
-  auto result = cachedFileInfos.find(fileID);
-  if (result != cachedFileInfos.end()) {
+void DiskCache::notifyFileSizeChanged(DiskCacheShard* shard, uint32_t fileID, size_t fileSize) {
+  {
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    auto result = shard->cachedFileInfos.find(fileID);
+    if (result == shard->cachedFileInfos.end()) {
+      return;
+    }
     totalDiskSize += fileSize - result->second->fileSize;
     result->second->fileSize = fileSize;
-    if (checkDiskSpace(maxDiskSize)) {
-      saveConfig();
-    }
+  }
+  if (totalDiskSize > maxDiskSize) {
+    scheduleEviction();
   }
 }
 
@@ -18,14 +18,29 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
 #include <unordered_map>
 #include "SequenceFile.h"
 #include "pag/types.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
 class FileInfo;
 
+/**
+ * A segment of the disk cache index. Keys are distributed to shards by their hash values, and
+ * every shard has its own lock and LRU list, so operations on different keys rarely contend.
+ */
+class DiskCacheShard {
+ public:
+  std::mutex locker = {};
+  std::unordered_map<std::string, uint32_t> cachedFileIDs = {};
+  std::unordered_map<uint32_t, std::shared_ptr<FileInfo>> cachedFileInfos = {};
+  std::list<std::shared_ptr<FileInfo>> cachedFiles = {};
+  std::unordered_map<uint32_t, std::weak_ptr<SequenceFile>> openedFiles = {};
+};
+
 class DiskCache {
  public:
   /**
@@ -50,23 +65,46 @@ class DiskCache {
   static bool WriteFile(const std::string& key, std::shared_ptr<tgfx::Data> data);
 
  private:
-  std::mutex locker = {};
   std::string configPath;
+  std::string journalPath;
   std::string cacheFolder;
-  uint32_t fileIDCount = 1;
-  size_t totalDiskSize = 0;
-  size_t maxDiskSize = 1073741824;  // 1 GB
-  std::unordered_map<std::string, uint32_t> cachedFileIDs = {};
-  std::unordered_map<uint32_t, std::shared_ptr<FileInfo>> cachedFileInfos = {};
-  std::list<std::shared_ptr<FileInfo>> cachedFiles = {};
-  std::unordered_map<uint32_t, std::weak_ptr<SequenceFile>> openedFiles = {};
+  std::vector<std::unique_ptr<DiskCacheShard>> shards = {};
+  std::atomic<uint32_t> fileIDCount = 1;
+  std::atomic<size_t> totalDiskSize = 0;
+  std::atomic<size_t> maxDiskSize = 1073741824;  // 1 GB
+  // A logical clock to compare the access time of files in different shards.
+  std::atomic<uint64_t> accessClock = 0;
+  std::atomic_bool compressionEnabled = true;
+  std::atomic_bool deltaCompressionEnabled = false;
+  // Serializes the eviction, which usually runs on a background thread.
+  std::mutex evictionLocker = {};
+  std::mutex evictionTaskLocker = {};
+  std::shared_ptr<tgfx::Task> evictionTask = nullptr;
+  std::atomic_bool evictionScheduled = false;
+  // Guards the journal records that are not written to disk yet.
+  std::mutex journalLocker = {};
+  std::vector<uint8_t> pendingJournal = {};
+  bool flushScheduled = false;
+  std::shared_ptr<tgfx::Task> flushTask = nullptr;
+  bool compactionRequested = false;
+  // Serializes the disk I/O of the config files, which runs on a background thread.
+  std::mutex configLocker = {};
+  size_t journalSize = 0;
 
   static DiskCache* GetInstance();
 
   DiskCache();
 
+  explicit DiskCache(const std::string& cacheDir);
+
+  ~DiskCache();
+
   size_t getMaxDiskSize();
   void setMaxDiskSize(size_t size);
+  bool getCompressionEnabled();
+  void setCompressionEnabled(bool value);
+  bool getDeltaCompressionEnabled();
+  void setDeltaCompressionEnabled(bool value);
   void removeAll();
   std::shared_ptr<SequenceFile> openSequence(const std::string& key, const tgfx::ImageInfo& info,
                                              int frameCount, float frameRate,
@@ -74,19 +112,33 @@ class DiskCache {
   std::shared_ptr<tgfx::Data> readFile(const std::string& key);
   bool writeFile(const std::string& key, std::shared_ptr<tgfx::Data> data);
 
+  DiskCacheShard* getShard(const std::string& key);
+  DiskCacheShard* getShard(uint32_t fileID);
+  std::shared_ptr<FileInfo> findFileInfo(uint32_t fileID, DiskCacheShard** shard);
+  size_t openedFileCount();
+  size_t cachedFileCount();
   bool checkDiskSpace(size_t maxSize);
-  void addToCachedFiles(std::shared_ptr<FileInfo> fileInfo);
-  void removeFromCachedFiles(std::shared_ptr<FileInfo> fileInfo);
-  void moveToFront(std::shared_ptr<FileInfo> fileInfo);
-  void moveToBeforeOpenedFiles(std::shared_ptr<FileInfo> fileInfo);
+  bool evictOldestFile();
+  void scheduleEviction();
+  void waitForEviction();
+  void addToCachedFiles(DiskCacheShard* shard, std::shared_ptr<FileInfo> fileInfo);
+  void removeFromCachedFiles(DiskCacheShard* shard, std::shared_ptr<FileInfo> fileInfo);
+  void moveToFront(DiskCacheShard* shard, std::shared_ptr<FileInfo> fileInfo);
+  void moveToBeforeOpenedFiles(DiskCacheShard* shard, std::shared_ptr<FileInfo> fileInfo);
   bool readConfig();
-  void saveConfig();
-  uint32_t getFileID(const std::string& key);
-  void changeToTemporary(uint32_t fileID);
+  bool readSnapshot();
+  bool replayJournal();
+  void appendJournal(uint8_t op, uint32_t fileID, const std::string& cacheKey = "");
+  void requestCompaction();
+  void scheduleConfigFlush();
+  void flushConfig();
+  std::shared_ptr<tgfx::Data> makeSnapshot();
+  uint32_t getFileID(DiskCacheShard* shard, const std::string& key);
+  void changeToTemporary(DiskCacheShard* shard, uint32_t fileID);
   std::string fileIDToPath(uint32_t fileID);
   uint32_t filePathToID(const std::string& path);
-  void notifyFileClosed(uint32_t fileID);
-  void notifyFileSizeChanged(uint32_t fileID, size_t fileSize);
+  void notifyFileClosed(DiskCacheShard* shard, uint32_t fileID);
+  void notifyFileSizeChanged(DiskCacheShard* shard, uint32_t fileID, size_t fileSize);
 
   friend class SequenceFile;
   friend class PAGDiskCache;
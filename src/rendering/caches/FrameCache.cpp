@@ -0,0 +1,52 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCache.h"
+
+namespace pag {
+static std::atomic<size_t> maxFrameCount = 0;
+static std::atomic<size_t> totalFrameCount = 0;
+static std::atomic<size_t> evictedFrameCount = 0;
+
+size_t FrameCacheBudget::MaxFrameCount() {
+  return maxFrameCount;
+}
+
+void FrameCacheBudget::SetMaxFrameCount(size_t count) {
+  maxFrameCount = count;
+}
+
+size_t FrameCacheBudget::TotalFrameCount() {
+  return totalFrameCount;
+}
+
+size_t FrameCacheBudget::EvictedFrameCount() {
+  return evictedFrameCount;
+}
+
+void FrameCacheBudget::FramesAdded(size_t count) {
+  totalFrameCount += count;
+}
+
+void FrameCacheBudget::FramesRemoved(size_t count, bool evicted) {
+  totalFrameCount -= count;
+  if (evicted) {
+    evictedFrameCount += count;
+  }
+}
+}  // namespace pag
@@ -18,10 +18,47 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <unordered_map>
 #include "pag/file.h"
+#include "rendering/caches/CacheEpoch.h"
 
 namespace pag {
+/**
+ * The settings and statistics shared by all FrameCaches.
+ */
+class FrameCacheBudget {
+ public:
+  /**
+   * Returns the maximum number of frames that each FrameCache keeps. 0 means no limit.
+   */
+  static size_t MaxFrameCount();
+
+  /**
+   * Sets the maximum number of frames that each FrameCache keeps. The least valuable frames are
+   * evicted by the clock algorithm when a FrameCache is full. 0 means no limit.
+   */
+  static void SetMaxFrameCount(size_t count);
+
+  /**
+   * Returns the total number of frames cached by all FrameCaches.
+   */
+  static size_t TotalFrameCount();
+
+  /**
+   * Returns the total number of frames evicted from all FrameCaches.
+   */
+  static size_t EvictedFrameCount();
+
+ private:
+  static void FramesAdded(size_t count);
+  static void FramesRemoved(size_t count, bool evicted);
+
+  template <typename T>
+  friend class FrameCache;
+};
+
 template <typename T>
 class FrameCache : public Cache {
  public:
@@ -35,9 +72,24 @@ class FrameCache : public Cache {
   }
 
   ~FrameCache() override {
-    for (auto& item : frames) {
+    auto frameChunks = chunks.load(std::memory_order_acquire);
+    if (frameChunks != nullptr) {
+      for (size_t i = 0; i < chunkCount(); i++) {
+        auto chunk = frameChunks[i].load(std::memory_order_relaxed);
+        if (chunk == nullptr) {
+          continue;
+        }
+        for (size_t j = 0; j < SlotsPerChunk; j++) {
+          delete chunk[j].cache.load(std::memory_order_relaxed);
+        }
+        delete[] chunk;
+      }
+      delete[] frameChunks;
+    }
+    for (auto& item : retiredCaches) {
       delete item.second;
     }
+    FrameCacheBudget::FramesRemoved(clockFrames.size(), false);
   }
 
   virtual T* getCache(Frame contentFrame) {
@@ -48,12 +100,36 @@ class FrameCache : public Cache {
     if (contentFrame < 0) {
       contentFrame = 0;
     }
+    // The fast path: a published cache is never modified, so no lock is required to read it.
+    auto foundSlot = findSlot(contentFrame);
+    if (foundSlot != nullptr) {
+      auto cache = foundSlot->cache.load(std::memory_order_acquire);
+      if (cache != nullptr) {
+        if (!foundSlot->referenced.load(std::memory_order_relaxed)) {
+          foundSlot->referenced.store(true, std::memory_order_relaxed);
+        }
+        return cache;
+      }
+    }
     std::lock_guard<std::mutex> autoLock(locker);
-    auto cache = frames[contentFrame];
+    auto& slot = makeSlot(contentFrame);
+    // Another thread may have created the cache while we were waiting for the lock.
+    auto cache = slot.cache.load(std::memory_order_relaxed);
+    if (cache != nullptr) {
+      return cache;
+    }
+    cache = createCache(contentFrame + startTime);
     if (cache == nullptr) {
-      cache = createCache(contentFrame + startTime);
-      frames[contentFrame] = cache;
+      return nullptr;
+    }
+    auto maxFrameCount = FrameCacheBudget::MaxFrameCount();
+    if (maxFrameCount > 0) {
+      evictFrames(maxFrameCount - 1);
     }
+    slot.referenced.store(false, std::memory_order_relaxed);
+    slot.cache.store(cache, std::memory_order_release);
+    clockFrames.push_back(contentFrame);
+    FrameCacheBudget::FramesAdded(1);
     return cache;
   }
 
@@ -69,7 +145,82 @@ class FrameCache : public Cache {
   virtual T* createCache(Frame layerFrame) = 0;
 
  private:
+  struct FrameSlot {
+    std::atomic<T*> cache = nullptr;
+    // Set when the frame is accessed again, which gives it a second chance to stay in the cache.
+    std::atomic_bool referenced = false;
+  };
+
+  // The slots are allocated in chunks on cache misses, so a long layer that only has a few distinct
+  // frames after merging its static time ranges does not pay for a slot of every frame.
+  static constexpr size_t SlotsPerChunk = 64;
+
   std::mutex locker = {};
-  std::unordered_map<Frame, T*> frames;
+  // The chunks indexed by the content frame, the table is allocated on the first cache miss.
+  std::atomic<std::atomic<FrameSlot*>*> chunks = nullptr;
+  // The cached frames in the order of the clock hand, only accessed with the locker held.
+  std::vector<Frame> clockFrames = {};
+  size_t clockHand = 0;
+  // The evicted caches may still be used by other threads, they are deleted once no thread can
+  // access them anymore.
+  std::deque<std::pair<uint64_t, T*>> retiredCaches = {};
+
+  size_t chunkCount() const {
+    return (static_cast<size_t>(duration) + SlotsPerChunk - 1) / SlotsPerChunk;
+  }
+
+  FrameSlot* findSlot(Frame contentFrame) const {
+    auto frameChunks = chunks.load(std::memory_order_acquire);
+    if (frameChunks == nullptr) {
+      return nullptr;
+    }
+    auto index = static_cast<size_t>(contentFrame);
+    auto chunk = frameChunks[index / SlotsPerChunk].load(std::memory_order_acquire);
+    return chunk != nullptr ? &chunk[index % SlotsPerChunk] : nullptr;
+  }
+
+  // Only called with the locker held.
+  FrameSlot& makeSlot(Frame contentFrame) {
+    auto frameChunks = chunks.load(std::memory_order_relaxed);
+    if (frameChunks == nullptr) {
+      frameChunks = new std::atomic<FrameSlot*>[chunkCount()];
+      for (size_t i = 0; i < chunkCount(); i++) {
+        frameChunks[i].store(nullptr, std::memory_order_relaxed);
+      }
+      chunks.store(frameChunks, std::memory_order_release);
+    }
+    auto index = static_cast<size_t>(contentFrame);
+    auto& chunkPointer = frameChunks[index / SlotsPerChunk];
+    auto chunk = chunkPointer.load(std::memory_order_relaxed);
+    if (chunk == nullptr) {
+      chunk = new FrameSlot[SlotsPerChunk];
+      chunkPointer.store(chunk, std::memory_order_release);
+    }
+    return chunk[index % SlotsPerChunk];
+  }
+
+  void evictFrames(size_t maxCount) {
+    while (!retiredCaches.empty() && CacheEpoch::IsReclaimable(retiredCaches.front().first)) {
+      delete retiredCaches.front().second;
+      retiredCaches.pop_front();
+    }
+    size_t evictedCount = 0;
+    while (clockFrames.size() > maxCount) {
+      if (clockHand >= clockFrames.size()) {
+        clockHand = 0;
+      }
+      auto& slot = *findSlot(clockFrames[clockHand]);
+      if (slot.referenced.exchange(false, std::memory_order_relaxed)) {
+        clockHand++;
+        continue;
+      }
+      auto cache = slot.cache.exchange(nullptr, std::memory_order_acq_rel);
+      retiredCaches.emplace_back(CacheEpoch::Current(), cache);
+      clockFrames[clockHand] = clockFrames.back();
+      clockFrames.pop_back();
+      evictedCount++;
+    }
+    FrameCacheBudget::FramesRemoved(evictedCount, true);
+  }
 };
 }  // namespace pag
@@ -17,13 +17,140 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "ImageContentCache.h"
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <unordered_map>
 #include "rendering/graphics/Picture.h"
 
 namespace pag {
-class ImageBytesCache : public Cache {
+// The recently used images are kept alive until their encoded sizes add up to this, so that the
+// templates loaded again after all their files are released still reuse them. The decoded pixels
+// are owned by the GPU resource cache, which already has its own budget.
+static constexpr size_t MAX_RETAINED_IMAGE_BYTES = 64 * 1024 * 1024;
+
+/**
+ * SharedImageCache deduplicates the embedded images across all the loaded files by the hash of
+ * their encoded bytes, so the identical images in different files are copied and decoded only once.
+ */
+class SharedImageCache {
  public:
-  static ImageBytesCache* Get(ImageBytes* imageBytes);
-  std::shared_ptr<Graphic> graphic = nullptr;
+  static SharedImageCache* Get() {
+    static auto& cache = *new SharedImageCache();
+    return &cache;
+  }
+
+  std::shared_ptr<SharedImage> findOrMake(const ByteData* fileBytes) {
+    if (fileBytes == nullptr) {
+      return nullptr;
+    }
+    auto hash = HashBytes(fileBytes->data(), fileBytes->length());
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto sharedImage = findImage(fileBytes, hash);
+    if (sharedImage == nullptr) {
+      sharedImage = makeImage(fileBytes, hash);
+      if (sharedImage == nullptr) {
+        return nullptr;
+      }
+    }
+    retainImage(sharedImage);
+    return sharedImage;
+  }
+
+  size_t retainedMemory() {
+    std::lock_guard<std::mutex> autoLock(locker);
+    return retainedBytes;
+  }
+
+  void purgeRetainedImages() {
+    std::lock_guard<std::mutex> autoLock(locker);
+    retainedImages.clear();
+    retainedPositions.clear();
+    retainedBytes = 0;
+    sweepExpiredImages();
+  }
+
+ private:
+  std::mutex locker = {};
+  std::unordered_multimap<uint64_t, std::weak_ptr<SharedImage>> images = {};
+  size_t sweepThreshold = 64;
+  std::list<std::shared_ptr<SharedImage>> retainedImages = {};
+  std::unordered_map<SharedImage*, std::list<std::shared_ptr<SharedImage>>::iterator>
+      retainedPositions = {};
+  size_t retainedBytes = 0;
+
+  static uint64_t HashBytes(const uint8_t* bytes, size_t length) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ULL;
+    }
+    return hash;
+  }
+
+  std::shared_ptr<SharedImage> findImage(const ByteData* fileBytes, uint64_t hash) {
+    auto range = images.equal_range(hash);
+    for (auto iter = range.first; iter != range.second;) {
+      auto sharedImage = iter->second.lock();
+      if (sharedImage == nullptr) {
+        iter = images.erase(iter);
+        continue;
+      }
+      if (sharedImage->data->size() == fileBytes->length() &&
+          memcmp(sharedImage->data->data(), fileBytes->data(), fileBytes->length()) == 0) {
+        return sharedImage;
+      }
+      iter++;
+    }
+    return nullptr;
+  }
+
+  std::shared_ptr<SharedImage> makeImage(const ByteData* fileBytes, uint64_t hash) {
+    // The image may outlive the file it comes from, so it keeps its own copy of the bytes.
+    auto data = tgfx::Data::MakeWithCopy(fileBytes->data(), fileBytes->length());
+    auto image = tgfx::Image::MakeFromEncoded(data);
+    if (image == nullptr) {
+      return nullptr;
+    }
+    auto sharedImage = std::make_shared<SharedImage>();
+    sharedImage->hash = hash;
+    sharedImage->data = std::move(data);
+    sharedImage->image = std::move(image);
+    if (images.size() >= sweepThreshold) {
+      sweepExpiredImages();
+    }
+    images.emplace(hash, sharedImage);
+    return sharedImage;
+  }
+
+  void retainImage(std::shared_ptr<SharedImage> sharedImage) {
+    auto result = retainedPositions.find(sharedImage.get());
+    if (result != retainedPositions.end()) {
+      retainedImages.splice(retainedImages.begin(), retainedImages, result->second);
+      return;
+    }
+    retainedBytes += sharedImage->data->size();
+    retainedImages.push_front(sharedImage);
+    retainedPositions[sharedImage.get()] = retainedImages.begin();
+    while (retainedBytes > MAX_RETAINED_IMAGE_BYTES && retainedImages.size() > 1) {
+      auto& oldest = retainedImages.back();
+      retainedBytes -= oldest->data->size();
+      retainedPositions.erase(oldest.get());
+      retainedImages.pop_back();
+    }
+  }
+
+  void sweepExpiredImages() {
+    for (auto iter = images.begin(); iter != images.end();) {
+      if (iter->second.expired()) {
+        iter = images.erase(iter);
+      } else {
+        iter++;
+      }
+    }
+    sweepThreshold = std::max(images.size() * 2, static_cast<size_t>(64));
+  }
 };
 
 ImageBytesCache* ImageBytesCache::Get(ImageBytes* imageBytes) {
@@ -32,10 +159,10 @@ ImageBytesCache* ImageBytesCache::Get(ImageBytes* imageBytes) {
     return static_cast<ImageBytesCache*>(imageBytes->cache);
   }
   auto cache = new ImageBytesCache();
-  auto fileBytes =
-      tgfx::Data::MakeWithCopy(imageBytes->fileBytes->data(), imageBytes->fileBytes->length());
-  auto image = tgfx::Image::MakeFromEncoded(std::move(fileBytes));
-  auto picture = Picture::MakeFrom(imageBytes->uniqueID, image);
+  cache->sharedImage = SharedImageCache::Get()->findOrMake(imageBytes->fileBytes);
+  auto image = cache->sharedImage ? cache->sharedImage->image : nullptr;
+  auto assetID = cache->sharedImage ? cache->sharedImage->uniqueID : imageBytes->uniqueID;
+  auto picture = Picture::MakeFrom(assetID, image);
   auto matrix = tgfx::Matrix::MakeScale(1 / imageBytes->scaleFactor);
   matrix.postTranslate(static_cast<float>(-imageBytes->anchorX),
                        static_cast<float>(-imageBytes->anchorY));
@@ -48,6 +175,19 @@ std::shared_ptr<Graphic> ImageContentCache::GetGraphic(ImageBytes* imageBytes) {
   return ImageBytesCache::Get(imageBytes)->graphic;
 }
 
+ID ImageContentCache::GetAssetID(ImageBytes* imageBytes) {
+  auto sharedImage = ImageBytesCache::Get(imageBytes)->sharedImage;
+  return sharedImage ? sharedImage->uniqueID : imageBytes->uniqueID;
+}
+
+size_t ImageContentCache::RetainedMemory() {
+  return SharedImageCache::Get()->retainedMemory();
+}
+
+void ImageContentCache::PurgeUnusedImages() {
+  SharedImageCache::Get()->purgeRetainedImages();
+}
+
 ImageContentCache::ImageContentCache(ImageLayer* layer) : ContentCache(layer) {
 }
 
@@ -19,13 +19,50 @@
 #pragma once
 
 #include "ContentCache.h"
+#include "base/utils/UniqueID.h"
+#include "tgfx/core/Image.h"
 #include "tgfx/core/ImageCodec.h"
 
 namespace pag {
+/**
+ * An encoded image shared by all the ImageBytes with the same content. Each ImageBytes applies its
+ * own scale factor when drawing it.
+ */
+struct SharedImage {
+  ID uniqueID = UniqueID::Next();
+  uint64_t hash = 0;
+  std::shared_ptr<tgfx::Data> data = nullptr;
+  std::shared_ptr<tgfx::Image> image = nullptr;
+};
+
+class ImageBytesCache : public Cache {
+ public:
+  static ImageBytesCache* Get(ImageBytes* imageBytes);
+  std::shared_ptr<SharedImage> sharedImage = nullptr;
+  std::shared_ptr<Graphic> graphic = nullptr;
+};
+
 class ImageContentCache : public ContentCache {
  public:
   static std::shared_ptr<Graphic> GetGraphic(ImageBytes* imageBytes);
 
+  /**
+   * Returns the asset ID used to cache the decoded image of the ImageBytes. All the ImageBytes
+   * sharing the same image return the same ID, so they also share the decoded images, mipmaps and
+   * snapshots in the RenderCache.
+   */
+  static ID GetAssetID(ImageBytes* imageBytes);
+
+  /**
+   * Returns the total size in bytes of the encoded images kept alive for reuse.
+   */
+  static size_t RetainedMemory();
+
+  /**
+   * Releases the shared images that are only kept alive for reuse by the files loaded later.
+   */
+  static void PurgeUnusedImages();
+
   explicit ImageContentCache(ImageLayer* layer);
 
  protected:
@@ -56,7 +56,7 @@ LayerCache::LayerCache(Layer* layer) : layer(layer) {
       break;
   }
   contentCache->update();
-  transformCache = new TransformCache(layer);
+  transformCache = TransformCache::Get(layer);
   bool hasFeatherMask = false;
   for (auto mask : layer->masks) {
     if (mask->maskFeather != nullptr ||
@@ -76,7 +76,6 @@ LayerCache::LayerCache(Layer* layer) : layer(layer) {
 }
 
 LayerCache::~LayerCache() {
-  delete transformCache;
   delete maskCache;
   delete contentCache;
   delete featherMaskCache;
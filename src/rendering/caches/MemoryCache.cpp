@@ -0,0 +1,58 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "MemoryCache.h"
+#include "FrameCache.h"
+#include "ImageContentCache.h"
+#include "pag/pag.h"
+#include "rendering/utils/FrameBufferPool.h"
+
+namespace pag {
+size_t PAGMemoryCache::MaxMemorySize() {
+  return MemoryCache::GetInstance()->maxMemorySize();
+}
+
+void PAGMemoryCache::SetMaxMemorySize(size_t size) {
+  MemoryCache::GetInstance()->setMaxMemorySize(size);
+}
+
+size_t PAGMemoryCache::MemoryUsage() {
+  return MemoryCache::GetInstance()->memoryUsage();
+}
+
+size_t PAGMemoryCache::MaxFrameCacheCount() {
+  return FrameCacheBudget::MaxFrameCount();
+}
+
+void PAGMemoryCache::SetMaxFrameCacheCount(size_t count) {
+  FrameCacheBudget::SetMaxFrameCount(count);
+}
+
+void PAGMemoryCache::PurgeUnusedImages() {
+  ImageContentCache::PurgeUnusedImages();
+}
+
+MemoryCache* MemoryCache::GetInstance() {
+  static auto& memoryCache = *new MemoryCache();
+  return &memoryCache;
+}
+
+size_t MemoryCache::memoryUsage() const {
+  return totalMemory + FrameBufferPool::Get()->freeBytes() + ImageContentCache::RetainedMemory();
+}
+}  // namespace pag
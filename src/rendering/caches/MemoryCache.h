@@ -0,0 +1,83 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace pag {
+/**
+ * MemoryCache tracks the memory usage of all RenderCaches in the process against one shared
+ * budget. Every RenderCache reports its own usage, and trims its caches by its share of the
+ * overage when the total usage exceeds the budget, so co-located players share the budget instead
+ * of each assuming the whole of it. The idle frame buffers kept by the FrameBufferPool and the
+ * encoded images retained by the ImageContentCache are also counted in the total usage.
+ */
+class MemoryCache {
+ public:
+  static MemoryCache* GetInstance();
+
+  /**
+   * Returns the memory budget shared by all RenderCaches in bytes.
+   */
+  size_t maxMemorySize() const {
+    return _maxMemorySize;
+  }
+
+  /**
+   * Sets the memory budget shared by all RenderCaches in bytes.
+   */
+  void setMaxMemorySize(size_t size) {
+    _maxMemorySize = size;
+  }
+
+  /**
+   * Returns the total memory usage of all RenderCaches, the idle frame buffers and the retained
+   * shared images in bytes.
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * Returns the number of bytes by which the total memory usage exceeds the budget.
+   */
+  size_t overBudgetSize() const {
+    size_t total = memoryUsage();
+    size_t maxSize = _maxMemorySize;
+    return total > maxSize ? total - maxSize : 0;
+  }
+
+  /**
+   * Replaces the memory usage previously reported by a RenderCache with the new one.
+   */
+  void updateMemoryUsage(size_t oldUsage, size_t newUsage) {
+    if (newUsage > oldUsage) {
+      totalMemory += newUsage - oldUsage;
+    } else {
+      totalMemory -= oldUsage - newUsage;
+    }
+  }
+
+ private:
+  std::atomic<size_t> totalMemory = 0;
+  // 300M设置的大一些用于兜底，通常在大于20M时就开始随时清理。
+  std::atomic<size_t> _maxMemorySize = 314572800;
+
+  MemoryCache() = default;
+};
+}  // namespace pag
@@ -17,32 +17,46 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "RenderCache.h"
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include "base/utils/TimeUtil.h"
 #include "base/utils/UniqueID.h"
+#include "rendering/caches/CacheEpoch.h"
+#include "rendering/caches/FrameCache.h"
 #include "rendering/caches/ImageContentCache.h"
 #include "rendering/caches/LayerCache.h"
+#include "rendering/caches/MemoryCache.h"
 #include "rendering/editing/ImageReplacement.h"
 #include "rendering/filters/utils/Filter3DFactory.h"
 #include "rendering/renderers/FilterRenderer.h"
 #include "rendering/sequences/SequenceImageProxy.h"
 #include "rendering/sequences/SequenceInfo.h"
+#include "rendering/utils/FrameBufferPool.h"
 #include "tgfx/core/Clock.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
-// 300M设置的大一些用于兜底，通常在大于20M时就开始随时清理。
-static constexpr int MAX_GRAPHICS_MEMORY = 314572800;
-static constexpr int PURGEABLE_GRAPHICS_MEMORY = 20971520;  // 20M
+static constexpr size_t PURGEABLE_GRAPHICS_MEMORY = 20971520;  // 20M
 static constexpr int PURGEABLE_EXPIRED_FRAME = 10;
 static constexpr float SCALE_FACTOR_PRECISION = 0.001f;
 static constexpr float MIPMAP_ENABLED_THRESHOLD = 0.4f;
-static constexpr int64_t DECODING_VISIBLE_DISTANCE = 500000;  // 提前 500ms 开始解码。
+// The sequences start decoding ahead for this multiple of their measured decoding time.
+static constexpr float PREFETCH_COST_FACTOR = 2.0f;
+// The content time jumps longer than this are seeking rather than playing.
+static constexpr int64_t MAX_PLAYBACK_STEP = 1000000;
+static constexpr size_t MAX_PREPARE_WORKERS = 4;
+
+static size_t DecodedImageMemory(const std::shared_ptr<tgfx::Image>& image) {
+  return static_cast<size_t>(image->width() * image->height()) * 4;
+}
 
 RenderCache::RenderCache(PAGStage* stage) : _uniqueID(UniqueID::Next()), stage(stage) {
 }
 
 RenderCache::~RenderCache() {
   releaseAll();
+  MemoryCache::GetInstance()->updateMemoryUsage(reportedMemory, 0);
 }
 
 uint32_t RenderCache::getContentVersion() const {
@@ -61,17 +75,42 @@ void RenderCache::setVideoEnabled(bool value) {
   clearAllSequenceCaches();
 }
 
+void RenderCache::setMaxPrefetchFrames(size_t value) {
+  if (value < 1) {
+    value = 1;
+  }
+  if (_maxPrefetchFrames == value) {
+    return;
+  }
+  _maxPrefetchFrames = value;
+  clearAllSequenceCaches();
+}
+
+void RenderCache::setPrefetchMemoryLimit(size_t value) {
+  if (_prefetchMemoryLimit == value) {
+    return;
+  }
+  _prefetchMemoryLimit = value;
+  clearAllSequenceCaches();
+}
+
 void RenderCache::prepareLayers() {
-  int64_t timeDistance = DECODING_VISIBLE_DISTANCE;
+  auto timeDistance = _prefetchWindow;
 #ifdef PAG_BUILD_FOR_WEB
   // always prepare the whole timeline on the web platoform.
   timeDistance = INT64_MAX;
 #endif
+  updatePlaybackRate();
+  auto decodingCount = countDecodingSequences();
+  // The layers are sorted by distance, the nearest ones take the decoding slots first.
   auto layerDistances = stage->findNearlyVisibleLayersIn(timeDistance);
   for (auto& item : layerDistances) {
     for (auto pagLayer : item.second) {
       if (pagLayer->layerType() == LayerType::PreCompose) {
-        preparePreComposeLayer(static_cast<PreComposeLayer*>(pagLayer->layer));
+        auto layer = static_cast<PreComposeLayer*>(pagLayer->layer);
+        if (item.first <= getPrefetchDistance(layer->composition->uniqueID, timeDistance)) {
+          preparePreComposeLayer(layer, &decodingCount);
+        }
       } else if (pagLayer->layerType() == LayerType::Image) {
         prepareImageLayer(static_cast<PAGImageLayer*>(pagLayer));
       }
@@ -79,7 +118,119 @@ void RenderCache::prepareLayers() {
   }
 }
 
-void RenderCache::preparePreComposeLayer(PreComposeLayer* layer) {
+void RenderCache::CollectVisibleLayers(PAGLayer* pagLayer,
+                                       std::vector<PAGLayer*>* visibleLayers) {
+  if (!pagLayer->layerVisible || !pagLayer->frameVisible()) {
+    return;
+  }
+  switch (pagLayer->layerType()) {
+    case LayerType::Shape:
+    case LayerType::Text:
+    case LayerType::Solid:
+      visibleLayers->push_back(pagLayer);
+      break;
+    case LayerType::PreCompose: {
+      auto composition = static_cast<PAGComposition*>(pagLayer);
+      if (!composition->contentModified() && composition->layerCache->contentStatic()) {
+        // The children are drawn from the cached content of the composition.
+        break;
+      }
+      for (auto& childLayer : composition->layers) {
+        CollectVisibleLayers(childLayer.get(), visibleLayers);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void RenderCache::PrepareLayer(PAGLayer* pagLayer) {
+  auto layerCache = pagLayer->layerCache;
+  layerCache->getTransform(pagLayer->contentFrame);
+  layerCache->getMasks(pagLayer->contentFrame);
+  pagLayer->getContent();
+}
+
+void RenderCache::prepareVisibleLayers() {
+#ifndef PAG_BUILD_FOR_WEB
+  if (!_parallelPrepareEnabled) {
+    return;
+  }
+  auto root = stage->getRootComposition();
+  if (root == nullptr) {
+    return;
+  }
+  std::vector<PAGLayer*> visibleLayers = {};
+  CollectVisibleLayers(root.get(), &visibleLayers);
+  if (visibleLayers.size() < 2) {
+    return;
+  }
+  // The layers are independent of each other, the caches they share are thread-safe. Every worker
+  // takes the next unprepared layer until none is left, the calling thread joins the workers too.
+  std::atomic_size_t nextIndex = {0};
+  auto prepareLayers = [&]() {
+    EpochGuard epochGuard;
+    size_t index;
+    while ((index = nextIndex.fetch_add(1, std::memory_order_relaxed)) < visibleLayers.size()) {
+      PrepareLayer(visibleLayers[index]);
+    }
+  };
+  auto workerCount = std::min(visibleLayers.size(), MAX_PREPARE_WORKERS) - 1;
+  std::vector<std::shared_ptr<tgfx::Task>> tasks = {};
+  for (size_t i = 0; i < workerCount; i++) {
+    tasks.push_back(tgfx::Task::Run(prepareLayers));
+  }
+  prepareLayers();
+  for (auto& task : tasks) {
+    task->wait();
+  }
+#endif
+}
+
+void RenderCache::updatePlaybackRate() {
+  auto root = stage->getRootComposition();
+  if (root == nullptr) {
+    return;
+  }
+  auto now = tgfx::Clock::Now();
+  auto playTime = root->currentTimeInternal();
+  auto elapsed = now - lastPrepareTime;
+  auto played = std::abs(playTime - lastPlayTime);
+  if (lastPrepareTime > 0 && elapsed > 0 && played > 0 && played < MAX_PLAYBACK_STEP) {
+    auto rate = std::max(0.25f, std::min(static_cast<float>(played) / elapsed, 4.0f));
+    playbackRate = playbackRate * 0.8f + rate * 0.2f;
+  }
+  lastPrepareTime = now;
+  lastPlayTime = playTime;
+}
+
+int64_t RenderCache::getPrefetchDistance(ID assetID, int64_t timeDistance) const {
+  auto result = decodingCosts.find(assetID);
+  if (result == decodingCosts.end()) {
+    // Starts at the beginning of the window if the sequence has never been decoded.
+    return timeDistance;
+  }
+  // Leaves at least two frames for the sequences that decode fast.
+  auto frameDuration = static_cast<int64_t>(1000000 / stage->frameRateInternal());
+  auto cost = static_cast<float>(result->second);
+  auto distance = static_cast<int64_t>(cost * PREFETCH_COST_FACTOR * playbackRate);
+  return std::min(std::max(distance, frameDuration * 2), timeDistance);
+}
+
+size_t RenderCache::countDecodingSequences() const {
+  size_t count = 0;
+  for (auto& item : sequenceCaches) {
+    for (auto queue : item.second) {
+      if (queue->isDecoding()) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+void RenderCache::preparePreComposeLayer(PreComposeLayer* layer, size_t* decodingCount) {
   auto composition = layer->composition;
   if (composition->type() != CompositionType::Video &&
       composition->type() != CompositionType::Bitmap) {
@@ -97,9 +248,13 @@ void RenderCache::preparePreComposeLayer(PreComposeLayer* layer) {
   if (result != sequenceCaches.end()) {
     return;
   }
+  if (_maxConcurrentPrefetches > 0 && *decodingCount >= _maxConcurrentPrefetches) {
+    return;
+  }
   auto queue = makeSequenceImageQueue(info);
   if (queue) {
     queue->prepareNextImage();
+    (*decodingCount)++;
   }
 }
 
@@ -164,7 +319,7 @@ void RenderCache::attachToContext(tgfx::Context* current, bool forDrawing) {
     releaseAll();
   }
   context = current;
-  context->setCacheLimit(MAX_GRAPHICS_MEMORY);
+  context->setCacheLimit(std::min(MemoryCache::GetInstance()->maxMemorySize(), contextCacheLimit));
   contextID = context->uniqueID();
   isDrawingFrame = forDrawing;
   if (!isDrawingFrame) {
@@ -184,6 +339,9 @@ void RenderCache::releaseAll() {
   graphicsMemory = 0;
   clearAllSequenceCaches();
   contextID = 0;
+  contextMemory = 0;
+  assetMemory = 0;
+  updateMemoryUsage();
 }
 
 void RenderCache::detachFromContext() {
@@ -206,6 +364,18 @@ void RenderCache::detachFromContext() {
     // is over 20M.
     context->purgeResourcesNotUsedSince(timestamps.front());
   }
+  contextMemory = context->memoryUsage();
+  assetMemory = 0;
+  for (auto& item : decodedAssetImages) {
+    assetMemory += DecodedImageMemory(item.second);
+  }
+  for (auto& item : sequenceCaches) {
+    for (auto queue : item.second) {
+      assetMemory += queue->memoryUsage();
+    }
+  }
+  updateMemoryUsage();
+  purgeOverBudget();
   timestamps.push(std::chrono::steady_clock::now());
   while (timestamps.size() > PURGEABLE_EXPIRED_FRAME) {
     timestamps.pop();
@@ -242,7 +412,7 @@ Snapshot* RenderCache::getSnapshot(const Picture* picture) {
     return snapshot;
   }
 
-  if (scaleFactor < SCALE_FACTOR_PRECISION || graphicsMemory >= MAX_GRAPHICS_MEMORY) {
+  if (scaleFactor < SCALE_FACTOR_PRECISION || MemoryCache::GetInstance()->overBudgetSize() > 0) {
     return nullptr;
   }
   auto minScaleFactor = stage->getAssetMinScale(picture->assetID);
@@ -258,6 +428,7 @@ Snapshot* RenderCache::getSnapshot(const Picture* picture) {
   snapshotLRU.push_front(snapshot);
   snapshotPositions[snapshot] = snapshotLRU.begin();
   snapshotCaches[picture->assetID] = snapshot;
+  updateMemoryUsage();
   return snapshot;
 }
 
@@ -270,6 +441,7 @@ void RenderCache::removeSnapshot(ID assetID) {
   graphicsMemory -= snapshot->second->memoryUsage();
   delete snapshot->second;
   snapshotCaches.erase(assetID);
+  updateMemoryUsage();
 }
 
 void RenderCache::moveSnapshotToHead(Snapshot* snapshot) {
@@ -296,6 +468,79 @@ void RenderCache::clearAllSnapshots() {
   snapshotPositions.clear();
 }
 
+void RenderCache::updateMemoryUsage() {
+  auto memoryUsage = contextMemory + graphicsMemory + assetMemory;
+  MemoryCache::GetInstance()->updateMemoryUsage(reportedMemory, memoryUsage);
+  reportedMemory = memoryUsage;
+}
+
+void RenderCache::purgeOverBudget() {
+  auto memoryCache = MemoryCache::GetInstance();
+  if (memoryCache->overBudgetSize() > 0) {
+    // The idle frame buffers and the images only retained for the files loaded later are not used
+    // by anyone, they are released before any cache.
+    FrameBufferPool::Get()->purge();
+    ImageContentCache::PurgeUnusedImages();
+  }
+  auto overBudgetSize = memoryCache->overBudgetSize();
+  auto totalMemory = memoryCache->memoryUsage();
+  if (overBudgetSize == 0 || totalMemory == 0) {
+    contextCacheLimit = SIZE_MAX;
+    return;
+  }
+  // Every cache only trims its own share of the overage, in proportion to its memory usage, so the
+  // player that flushes first does not take the whole cut for the others.
+  auto purgeSize = static_cast<size_t>(std::ceil(static_cast<double>(overBudgetSize) *
+                                                 static_cast<double>(reportedMemory) /
+                                                 static_cast<double>(totalMemory)));
+  auto targetMemory = reportedMemory > purgeSize ? reportedMemory - purgeSize : 0;
+  // Releases the idle snapshots first, the ones that have been idle for the longest time and take
+  // the most memory are the least valuable.
+  std::vector<Snapshot*> idleSnapshots = {};
+  for (auto snapshot : snapshotLRU) {
+    if (usedAssets.count(snapshot->assetID) == 0) {
+      idleSnapshots.push_back(snapshot);
+    }
+  }
+  std::sort(idleSnapshots.begin(), idleSnapshots.end(), [](Snapshot* a, Snapshot* b) {
+    if (a->idleFrames != b->idleFrames) {
+      return a->idleFrames > b->idleFrames;
+    }
+    return a->memoryUsage() > b->memoryUsage();
+  });
+  for (auto snapshot : idleSnapshots) {
+    if (reportedMemory <= targetMemory) {
+      return;
+    }
+    removeSnapshot(snapshot->assetID);
+  }
+  if (reportedMemory <= targetMemory) {
+    return;
+  }
+  // Then the prefetched sequence frames and the images decoded ahead, which can be decoded again on
+  // demand.
+  for (auto& item : sequenceCaches) {
+    for (auto queue : item.second) {
+      auto releasedMemory = queue->releaseQueuedFrames();
+      assetMemory -= std::min(assetMemory, releasedMemory);
+    }
+  }
+  auto releasedMemory = releaseDecodedImages();
+  assetMemory -= std::min(assetMemory, releasedMemory);
+  updateMemoryUsage();
+  // Then the snapshots in use, from the least recently used one. No new snapshot is created until
+  // the usage drops below the budget.
+  while (reportedMemory > targetMemory && !snapshotLRU.empty()) {
+    removeSnapshot(snapshotLRU.back()->assetID);
+  }
+  // Finally, shrinks the GPU resource cache of the context by the rest of its share.
+  if (reportedMemory > targetMemory) {
+    auto remainingSize = reportedMemory - targetMemory;
+    contextCacheLimit = contextMemory > remainingSize ? contextMemory - remainingSize : 0;
+    context->setCacheLimit(contextCacheLimit);
+  }
+}
+
 void RenderCache::clearExpiredSnapshots() {
   std::vector<Snapshot*> expiredSnapshots;
   size_t releaseMemory = 0;
@@ -378,6 +623,15 @@ void RenderCache::clearExpiredDecodedImages() {
   expiredList = {};
 }
 
+size_t RenderCache::releaseDecodedImages() {
+  size_t releasedMemory = 0;
+  for (auto& item : decodedAssetImages) {
+    releasedMemory += DecodedImageMemory(item.second);
+  }
+  decodedAssetImages.clear();
+  return releasedMemory;
+}
+
 //===================================== sequence caches =====================================
 
 void RenderCache::prepareSequenceImage(std::shared_ptr<SequenceInfo> sequence, Frame targetFrame) {
@@ -472,7 +726,9 @@ SequenceImageQueue* RenderCache::makeSequenceImageQueue(std::shared_ptr<Sequence
     return nullptr;
   }
   auto layer = stage->getLayerFromReferenceMap(sequence->uniqueID());
-  auto queue = SequenceImageQueue::MakeFrom(sequence, layer, _useDiskCache).release();
+  auto queue = SequenceImageQueue::MakeFrom(sequence, layer, _useDiskCache, _maxPrefetchFrames,
+                                            _prefetchMemoryLimit)
+                   .release();
   if (queue == nullptr) {
     return nullptr;
   }
@@ -481,10 +737,18 @@ SequenceImageQueue* RenderCache::makeSequenceImageQueue(std::shared_ptr<Sequence
   return queue;
 }
 
+void RenderCache::recordDecodingCost(ID assetID, SequenceImageQueue* queue) {
+  auto cost = queue->decodingCost();
+  if (cost > 0) {
+    decodingCosts[assetID] = cost;
+  }
+}
+
 void RenderCache::clearAllSequenceCaches() {
   for (auto& item : sequenceCaches) {
     removeSnapshot(item.first);
     for (auto queue : item.second) {
+      recordDecodingCost(item.first, queue);
       delete queue;
     }
   }
@@ -496,6 +760,7 @@ void RenderCache::clearSequenceCache(ID uniqueID) {
   if (result != sequenceCaches.end()) {
     removeSnapshot(result->first);
     for (auto queue : result->second) {
+      recordDecodingCost(uniqueID, queue);
       delete queue;
     }
     sequenceCaches.erase(result);
@@ -511,6 +776,7 @@ std::shared_ptr<File> RenderCache::getFileByAssetID(ID assetID) {
 }
 
 void RenderCache::recordPerformance() {
+  frameCacheCount = static_cast<int64_t>(FrameCacheBudget::TotalFrameCount());
   for (auto& item : sequenceCaches) {
     for (auto& queue : item.second) {
       queue->reportPerformance(this);
@@ -75,6 +75,27 @@ class RenderCache : public Performance {
    */
   void prepareLayers();
 
+  /**
+   * Builds the transforms, masks and contents of the layers visible at the current frame in
+   * parallel, so that the following drawing only records the ready results.
+   */
+  void prepareVisibleLayers();
+
+  /**
+   * If set to false, the prepareVisibleLayers() does nothing and the layers are built while
+   * drawing. The default value is true.
+   */
+  bool parallelPrepareEnabled() const {
+    return _parallelPrepareEnabled;
+  }
+
+  /**
+   * Set the value of parallelPrepareEnabled property.
+   */
+  void setParallelPrepareEnabled(bool value) {
+    _parallelPrepareEnabled = value;
+  }
+
   /**
    * If set to false, the getSnapshot() always returns nullptr. The default value is true.
    */
@@ -144,6 +165,62 @@ class RenderCache : public Performance {
 
   void setVideoEnabled(bool value);
 
+  /**
+   * Returns the maximum number of frames that each video or bitmap sequence decodes ahead of the
+   * current frame. The default value is 1.
+   */
+  size_t maxPrefetchFrames() const {
+    return _maxPrefetchFrames;
+  }
+
+  /**
+   * Set the value of maxPrefetchFrames property.
+   */
+  void setMaxPrefetchFrames(size_t value);
+
+  /**
+   * Returns the maximum memory in bytes that the prefetched frames of each sequence can use. 0
+   * means no limit. The default value is 0.
+   */
+  size_t prefetchMemoryLimit() const {
+    return _prefetchMemoryLimit;
+  }
+
+  /**
+   * Set the value of prefetchMemoryLimit property.
+   */
+  void setPrefetchMemoryLimit(size_t value);
+
+  /**
+   * Returns the maximum time in microseconds ahead of the current position that the sequences start
+   * decoding. The default value is 500000.
+   */
+  int64_t prefetchWindow() const {
+    return _prefetchWindow;
+  }
+
+  /**
+   * Set the value of prefetchWindow property.
+   */
+  void setPrefetchWindow(int64_t value) {
+    _prefetchWindow = value;
+  }
+
+  /**
+   * Returns the maximum number of sequences that decode ahead at the same time. 0 means no limit.
+   * The default value is 0.
+   */
+  size_t maxConcurrentPrefetches() const {
+    return _maxConcurrentPrefetches;
+  }
+
+  /**
+   * Set the value of maxConcurrentPrefetches property.
+   */
+  void setMaxConcurrentPrefetches(size_t value) {
+    _maxConcurrentPrefetches = value;
+  }
+
   void prepareSequenceImage(std::shared_ptr<SequenceInfo> sequence, Frame targetFrame);
 
   std::shared_ptr<tgfx::Image> getSequenceImage(std::shared_ptr<SequenceInfo> sequence,
@@ -167,9 +244,25 @@ class RenderCache : public Performance {
   std::queue<std::chrono::steady_clock::time_point> timestamps = {};
   bool isDrawingFrame = false;
   size_t graphicsMemory = 0;
+  size_t contextMemory = 0;
+  size_t assetMemory = 0;
+  // The memory usage last reported to the MemoryCache.
+  size_t reportedMemory = 0;
+  size_t contextCacheLimit = SIZE_MAX;
   bool _videoEnabled = true;
   bool _snapshotEnabled = true;
   bool _useDiskCache = false;
+  bool _parallelPrepareEnabled = true;
+  size_t _maxPrefetchFrames = 1;
+  size_t _prefetchMemoryLimit = 0;
+  int64_t _prefetchWindow = 500000;
+  size_t _maxConcurrentPrefetches = 0;
+  // The longest decoding time of a frame measured for each sequence, in microseconds.
+  std::unordered_map<ID, int64_t> decodingCosts = {};
+  // The ratio of the content time to the real time elapsed between two preparations.
+  float playbackRate = 1.0f;
+  int64_t lastPrepareTime = 0;
+  int64_t lastPlayTime = 0;
   std::unordered_set<ID> usedAssets = {};
   std::unordered_map<ID, Snapshot*> snapshotCaches = {};
   std::list<Snapshot*> snapshotLRU = {};
@@ -181,12 +274,15 @@ class RenderCache : public Performance {
 
   // decoded image caches:
   void clearExpiredDecodedImages();
+  size_t releaseDecodedImages();
 
   // snapshot caches:
   void clearAllSnapshots();
   void clearExpiredSnapshots();
   void moveSnapshotToHead(Snapshot* snapshot);
   void removeSnapshotFromLRU(Snapshot* snapshot);
+  void updateMemoryUsage();
+  void purgeOverBudget();
 
   // sequence caches:
   SequenceImageQueue* getSequenceImageQueue(std::shared_ptr<SequenceInfo> sequence,
@@ -196,9 +292,15 @@ class RenderCache : public Performance {
   SequenceImageQueue* makeSequenceImageQueue(std::shared_ptr<SequenceInfo> sequence);
   void clearAllSequenceCaches();
   void clearSequenceCache(ID uniqueID);
+  void recordDecodingCost(ID assetID, SequenceImageQueue* queue);
   void clearExpiredSequences();
 
-  void preparePreComposeLayer(PreComposeLayer* layer);
+  static void CollectVisibleLayers(PAGLayer* pagLayer, std::vector<PAGLayer*>* visibleLayers);
+  static void PrepareLayer(PAGLayer* pagLayer);
+  void updatePlaybackRate();
+  int64_t getPrefetchDistance(ID assetID, int64_t timeDistance) const;
+  size_t countDecodingSequences() const;
+  void preparePreComposeLayer(PreComposeLayer* layer, size_t* decodingCount);
   void prepareImageLayer(PAGImageLayer* layer);
   void prepareNextFrame();
   std::shared_ptr<tgfx::Image> getAssetImageInternal(ID assetID, const ImageProxy* proxy);
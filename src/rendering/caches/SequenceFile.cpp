@@ -17,9 +17,20 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SequenceFile.h"
+#include <fcntl.h>
+#include <cerrno>
 #include <cstring>
+#if defined(_WIN32)
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include "DiskCache.h"
 #include "base/utils/Log.h"
+#include "base/utils/UniqueID.h"
 #include "pag/file.h"
 #include "rendering/utils/Directory.h"
 #include "tgfx/core/Buffer.h"
@@ -50,63 +61,257 @@ static constexpr uint32_t TIME_RANGE_SIZE = 8;
  * [frameSize: uint64_t]
  */
 static constexpr uint32_t FRAME_HEAD_SIZE = 12;
+/**
+ * The highest bit of the frameIndex is set if the frame is a delta frame.
+ */
+static constexpr uint32_t DELTA_FRAME_FLAG = 0x80000000;
+/**
+ * Forces a keyframe after this number of frames to keep seeking in a delta sequence bounded.
+ */
+static constexpr int KEYFRAME_INTERVAL = 10;
+/**
+ * The maximum number of recently written frames to keep as the references of delta frames, which
+ * allows several writers to append frames in different ranges at the same time.
+ */
+static constexpr size_t MAX_REFERENCE_FRAMES = 4;
+
+#if defined(_WIN32)
+static constexpr size_t MAX_IO_CHUNK_SIZE = 0x40000000;
+#endif
+
+static int OpenFile(const std::string& filePath) {
+#if defined(_WIN32)
+  return _open(filePath.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  return open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+#endif
+}
+
+static void CloseFile(int fd) {
+#if defined(_WIN32)
+  _close(fd);
+#else
+  close(fd);
+#endif
+}
+
+static size_t GetFileSize(int fd) {
+#if defined(_WIN32)
+  auto size = _lseeki64(fd, 0, SEEK_END);
+#else
+  auto size = lseek(fd, 0, SEEK_END);
+#endif
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+static bool TruncateFile(int fd) {
+#if defined(_WIN32)
+  return _chsize_s(fd, 0) == 0;
+#else
+  return ftruncate(fd, 0) == 0;
+#endif
+}
+
+/**
+ * Reads the bytes at the specified offset of the file without moving the shared file position, so
+ * it is safe to call from multiple threads at the same time.
+ */
+static bool ReadAt(int fd, void* buffer, size_t size, size_t offset) {
+  auto bytes = reinterpret_cast<uint8_t*>(buffer);
+  while (size > 0) {
+#if defined(_WIN32)
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+    DWORD readLength = 0;
+    auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    auto chunkSize = static_cast<DWORD>(size > MAX_IO_CHUNK_SIZE ? MAX_IO_CHUNK_SIZE : size);
+    if (!ReadFile(handle, bytes, chunkSize, &readLength, &overlapped) || readLength == 0) {
+      return false;
+    }
+#else
+    auto readLength = pread(fd, bytes, size, static_cast<off_t>(offset));
+    if (readLength < 0 && errno == EINTR) {
+      continue;
+    }
+    if (readLength <= 0) {
+      return false;
+    }
+#endif
+    bytes += readLength;
+    size -= static_cast<size_t>(readLength);
+    offset += static_cast<size_t>(readLength);
+  }
+  return true;
+}
+
+/**
+ * Writes the bytes at the specified offset of the file without moving the shared file position.
+ */
+static bool WriteAt(int fd, const void* buffer, size_t size, size_t offset) {
+  auto bytes = reinterpret_cast<const uint8_t*>(buffer);
+  while (size > 0) {
+#if defined(_WIN32)
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+    DWORD writeLength = 0;
+    auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    auto chunkSize = static_cast<DWORD>(size > MAX_IO_CHUNK_SIZE ? MAX_IO_CHUNK_SIZE : size);
+    if (!WriteFile(handle, bytes, chunkSize, &writeLength, &overlapped) || writeLength == 0) {
+      return false;
+    }
+#else
+    auto writeLength = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+    if (writeLength < 0 && errno == EINTR) {
+      continue;
+    }
+    if (writeLength <= 0) {
+      return false;
+    }
+#endif
+    bytes += writeLength;
+    size -= static_cast<size_t>(writeLength);
+    offset += static_cast<size_t>(writeLength);
+  }
+  return true;
+}
+
+static uint8_t* MapFile(int fd, size_t size) {
+#if defined(_WIN32)
+  auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+  auto mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    return nullptr;
+  }
+  auto address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+  // The view keeps a reference to the mapping object.
+  CloseHandle(mapping);
+  return reinterpret_cast<uint8_t*>(address);
+#elif defined(__EMSCRIPTEN__)
+  return nullptr;
+#else
+  auto address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  return address == MAP_FAILED ? nullptr : reinterpret_cast<uint8_t*>(address);
+#endif
+}
+
+static void UnmapFile(uint8_t* address, size_t size) {
+#if defined(_WIN32)
+  UnmapViewOfFile(address);
+#elif !defined(__EMSCRIPTEN__)
+  munmap(address, size);
+#endif
+}
+
+/**
+ * Computes dst = a ^ b, the result is all zeros where the two frames are the same, which compresses
+ * extremely well.
+ */
+static void XorPixels(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t size) {
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t x, y;
+    memcpy(&x, a + i, sizeof(uint64_t));
+    memcpy(&y, b + i, sizeof(uint64_t));
+    x ^= y;
+    memcpy(dst + i, &x, sizeof(uint64_t));
+  }
+  for (; i < size; i++) {
+    dst[i] = a[i] ^ b[i];
+  }
+}
+
+/**
+ * The per-thread state to decode delta frames. It keeps the last decoded frame, so reading a delta
+ * sequence in order only decodes one frame each time.
+ */
+struct DeltaDecodingContext {
+  uint32_t fileID = 0;
+  int index = -1;
+  tgfx::Buffer lastFrame = {};
+  tgfx::Buffer delta = {};
+};
+
+static DeltaDecodingContext* GetDeltaDecodingContext() {
+  static thread_local DeltaDecodingContext context = {};
+  return &context;
+}
+
+/**
+ * Returns a scratch buffer owned by the calling thread, which is used to hold the compressed bytes
+ * of a frame while reading. The buffer only grows and is released when the thread exits.
+ */
+static uint8_t* GetReadBuffer(size_t size) {
+  static thread_local tgfx::Buffer buffer = {};
+  if (buffer.size() < size) {
+    buffer.alloc(size);
+  }
+  return buffer.isEmpty() ? nullptr : buffer.bytes();
+}
 
 std::shared_ptr<SequenceFile> SequenceFile::Open(const std::string& filePath,
                                                  const tgfx::ImageInfo& info, int frameCount,
                                                  float frameRate,
-                                                 const std::vector<TimeRange>& staticTimeRanges) {
+                                                 const std::vector<TimeRange>& staticTimeRanges,
+                                                 CompressionType compressionType) {
   if (filePath.empty() || info.isEmpty() || frameCount == 0 || frameRate <= 0) {
     return nullptr;
   }
   auto sequenceFile = std::shared_ptr<SequenceFile>(
-      new SequenceFile(filePath, info, frameCount, frameRate, staticTimeRanges));
-  return sequenceFile->file ? sequenceFile : nullptr;
+      new SequenceFile(filePath, info, frameCount, frameRate, staticTimeRanges, compressionType));
+  return sequenceFile->fd >= 0 ? sequenceFile : nullptr;
 }
 
 SequenceFile::SequenceFile(const std::string& filePath, const tgfx::ImageInfo& info, int frameCount,
-                           float frameRate, std::vector<TimeRange> staticTimeRanges)
-    : _info(info), _numFrames(frameCount), _frameRate(frameRate),
+                           float frameRate, std::vector<TimeRange> staticTimeRanges,
+                           CompressionType compressionType)
+    : uniqueID(UniqueID::Next()), compressionType(compressionType), _info(info),
+      _numFrames(frameCount), _frameRate(frameRate),
       _staticTimeRanges(std::move(staticTimeRanges)) {
-  decoder = LZ4Decoder::Make();
   Directory::CreateRecursively(Directory::GetParentDirectory(filePath));
-#ifdef __APPLE__
-  compressionType = CompressionType::LZ4_APPLE;
-#endif
-  frames.resize(frameCount, {0, 0});
-  file = fopen(filePath.c_str(), "ab+");
-  if (file == nullptr) {
+  if (compressionType == CompressionType::LZ4_DELTA) {
+    decoder = LZ4Decoder::MakeRaw();
+  } else if (compressionType != CompressionType::None) {
+    decoder = LZ4Decoder::Make();
+  }
+  frames = std::make_unique<FrameLocation[]>(static_cast<size_t>(frameCount));
+  fd = OpenFile(filePath);
+  if (fd < 0) {
     return;
   }
-  fseek(file, 0, SEEK_END);
-  _fileSize = static_cast<size_t>(ftell(file));
+  _fileSize = GetFileSize(fd);
   if (_fileSize == 0) {
     return;
   }
   if (!readFramesFromFile()) {
-    cachedFrames = 0;
-    memset(frames.data(), 0, sizeof(FrameLocation) * frames.size());
+    resetFrames();
     _fileSize = 0;
-    fclose(file);
-    file = fopen(filePath.c_str(), "wb+");
+    if (!TruncateFile(fd)) {
+      CloseFile(fd);
+      fd = -1;
+    }
     LOGE("The existing sequence file has been reset, which may be corrupted!");
   }
 }
 
 SequenceFile::~SequenceFile() {
-  if (file != nullptr) {
-    fclose(file);
+  auto bytes = mappedBytes.load();
+  if (bytes != nullptr) {
+    UnmapFile(bytes, mappedSize);
+  }
+  if (fd >= 0) {
+    CloseFile(fd);
   }
   if (diskCache) {
-    diskCache->notifyFileClosed(fileID);
+    diskCache->notifyFileClosed(diskCacheShard, fileID);
   }
 }
 
 bool SequenceFile::readFramesFromFile() {
-  fseek(file, 0, SEEK_SET);
   tgfx::Buffer buffer(FILE_HEAD_SIZE);
   auto data = tgfx::DataView(buffer.bytes(), buffer.size());
-  auto readLength = fread(data.writableBytes(), 1, data.size(), file);
-  if (readLength != data.size()) {
+  if (!ReadAt(fd, data.writableBytes(), FILE_HEAD_SIZE, 0)) {
     return false;
   }
   auto version = data.getUint8(0);
@@ -127,54 +332,66 @@ bool SequenceFile::readFramesFromFile() {
       fileFrameRate != _frameRate || staticTimeRangeCount != _staticTimeRanges.size()) {
     return false;
   }
+  size_t position = FILE_HEAD_SIZE;
   for (uint32_t i = 0; i < staticTimeRangeCount; i++) {
-    readLength = fread(data.writableBytes(), 1, TIME_RANGE_SIZE, file);
-    if (readLength != TIME_RANGE_SIZE) {
+    if (!ReadAt(fd, data.writableBytes(), TIME_RANGE_SIZE, position)) {
       return false;
     }
+    position += TIME_RANGE_SIZE;
     const auto& timeRange = _staticTimeRanges[i];
     if (timeRange.start != data.getUint32(0) || timeRange.end != data.getUint32(4)) {
       return false;
     }
   }
-  long position = 0;
-  while (true) {
-    readLength = fread(data.writableBytes(), 1, FRAME_HEAD_SIZE, file);
-    if (readLength == 0) {
-      break;
-    }
-    if (readLength != FRAME_HEAD_SIZE) {
+  int frameCount = 0;
+  while (position < _fileSize) {
+    if (!ReadAt(fd, data.writableBytes(), FRAME_HEAD_SIZE, position)) {
       return false;
     }
     auto frameIndex = data.getUint32(0);
     auto frameSize = data.getUint64(4);
-    if (frameIndex >= static_cast<uint32_t>(_numFrames)) {
+    auto keyframe = true;
+    if (compressionType == CompressionType::LZ4_DELTA) {
+      keyframe = (frameIndex & DELTA_FRAME_FLAG) == 0;
+      frameIndex &= ~DELTA_FRAME_FLAG;
+    }
+    if (frameIndex >= static_cast<uint32_t>(_numFrames) || frameSize == 0) {
       return false;
     }
     auto& frame = frames[frameIndex];
-    frame.offset = static_cast<size_t>(ftell(file));
+    frame.offset = position + FRAME_HEAD_SIZE;
+    frame.keyframe = keyframe;
     frame.size = frameSize;
-    cachedFrames++;
-    if (fseek(file, static_cast<long>(frameSize), SEEK_CUR)) {
-      return false;
-    }
-    position = ftell(file);
+    frameCount++;
+    position += FRAME_HEAD_SIZE + frameSize;
   }
-  if (position != static_cast<long>(_fileSize)) {
+  if (position != _fileSize) {
     return false;
   }
   for (auto& timeRange : _staticTimeRanges) {
     auto& firstFrame = frames[timeRange.start];
     if (firstFrame.size > 0) {
-      cachedFrames += static_cast<int>(timeRange.duration()) - 1;
+      frameCount += static_cast<int>(timeRange.duration()) - 1;
       for (auto i = timeRange.start + 1; i <= timeRange.end; i++) {
-        frames[i] = firstFrame;
+        frames[i].offset = firstFrame.offset;
+        frames[i].keyframe = firstFrame.keyframe;
+        frames[i].size = firstFrame.size.load();
       }
     }
   }
+  cachedFrames = frameCount;
   return true;
 }
 
+void SequenceFile::resetFrames() {
+  for (int i = 0; i < _numFrames; i++) {
+    frames[i].offset = 0;
+    frames[i].keyframe = true;
+    frames[i].size = 0;
+  }
+  cachedFrames = 0;
+}
+
 bool SequenceFile::writeFileHead() {
   tgfx::Buffer buffer(FILE_HEAD_SIZE + _staticTimeRanges.size() * 8);
   auto data = tgfx::DataView(buffer.bytes(), buffer.size());
@@ -193,27 +410,23 @@ bool SequenceFile::writeFileHead() {
     data.setUint32(offset, static_cast<uint32_t>(_staticTimeRanges[i].start));
     data.setUint32(offset + 4, static_cast<uint32_t>(_staticTimeRanges[i].end));
   }
-  auto writeLength = fwrite(data.bytes(), 1, data.size(), file);
-  _fileSize = writeLength;
-  if (writeLength != data.size()) {
+  if (!WriteAt(fd, data.bytes(), data.size(), 0)) {
     LOGE("SequenceFile::writeFileHead() write file head failed!");
     return false;
   }
+  _fileSize = data.size();
   return true;
 }
 
 size_t SequenceFile::fileSize() {
-  std::lock_guard<std::mutex> autoLock(locker);
   return _fileSize;
 }
 
 bool SequenceFile::isComplete() {
-  std::lock_guard<std::mutex> autoLock(locker);
   return cachedFrames == _numFrames;
 }
 
 bool SequenceFile::readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
-  std::lock_guard<std::mutex> autoLock(locker);
   if (index < 0 || index >= _numFrames || bitmap == nullptr) {
     LOGE("SequenceFile::readFrame() invalid index or pixels!");
     return false;
@@ -223,30 +436,59 @@ bool SequenceFile::readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
     return false;
   }
   const auto& frame = frames[index];
-  if (frame.size == 0) {
+  auto frameSize = frame.size.load(std::memory_order_acquire);
+  if (frameSize == 0) {
     return false;
   }
-  if (!checkScratchBuffer()) {
-    return false;
-  }
-  if (fseek(file, static_cast<long>(frame.offset), SEEK_SET)) {
-    LOGE("SequenceFile::readFrame() fseek failed! (offset: %zu)", frame.offset);
-    return false;
-  }
-  auto encodedLength = fread(scratchBuffer.bytes(), 1, frame.size, file);
-  if (encodedLength != frame.size) {
-    LOGE("SequenceFile::readFrame() fread failed! (size: %zu)", frame.size);
-    return false;
-  }
-  auto byteSize = _info.byteSize();
-  auto pixels = bitmap->lockPixels();
+  auto pixels = reinterpret_cast<uint8_t*>(bitmap->lockPixels());
   if (pixels == nullptr) {
     LOGE("SequenceFile::readFrame() failed to lock pixels from the specified bitmap!");
     return false;
   }
-  auto decodedLength = decoder->decode(reinterpret_cast<uint8_t*>(pixels), byteSize,
-                                       scratchBuffer.bytes(), encodedLength);
+  bool success;
+  if (compressionType == CompressionType::LZ4_DELTA) {
+    success = readDeltaFrame(index, pixels);
+  } else {
+    success = decodeFrame(frame, frameSize, pixels);
+  }
   bitmap->unlockPixels();
+  return success;
+}
+
+int SequenceFile::storedIndex(int index) const {
+  return static_cast<int>(GetTimeRangeContains(_staticTimeRanges, index).start);
+}
+
+bool SequenceFile::decodeFrame(const FrameLocation& frame, size_t frameSize, uint8_t* pixels) {
+  auto byteSize = _info.byteSize();
+  auto mappedFile = getMappedBytes();
+  const uint8_t* encodedBytes = nullptr;
+  if (mappedFile != nullptr) {
+    encodedBytes = mappedFile + frame.offset;
+  } else if (compressionType != CompressionType::None) {
+    auto readBuffer = GetReadBuffer(frameSize);
+    if (readBuffer == nullptr) {
+      LOGE("SequenceFile::readFrame() failed to alloc the read buffer! (size: %zu)", frameSize);
+      return false;
+    }
+    if (!ReadAt(fd, readBuffer, frameSize, frame.offset)) {
+      LOGE("SequenceFile::readFrame() read failed! (offset: %zu, size: %zu)", frame.offset,
+           frameSize);
+      return false;
+    }
+    encodedBytes = readBuffer;
+  }
+  size_t decodedLength = 0;
+  if (compressionType != CompressionType::None) {
+    decodedLength = decoder->decode(pixels, byteSize, encodedBytes, frameSize);
+  } else if (frameSize == byteSize) {
+    if (encodedBytes != nullptr) {
+      memcpy(pixels, encodedBytes, byteSize);
+      decodedLength = byteSize;
+    } else if (ReadAt(fd, pixels, byteSize, frame.offset)) {
+      decodedLength = byteSize;
+    }
+  }
   if (decodedLength != byteSize) {
     LOGE("SequenceFile::readFrame() decode failed! (decoded: %zu, expected: %zu)", decodedLength,
          byteSize);
@@ -255,6 +497,91 @@ bool SequenceFile::readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
   return true;
 }
 
+bool SequenceFile::readDeltaFrame(int index, uint8_t* pixels) {
+  auto context = GetDeltaDecodingContext();
+  auto byteSize = _info.byteSize();
+  // Walks back to the nearest keyframe, or the frame decoded last time by this thread.
+  std::vector<int> chain = {};
+  auto current = storedIndex(index);
+  auto startFromLastFrame = false;
+  while (true) {
+    if (context->fileID == uniqueID && context->index == current) {
+      startFromLastFrame = true;
+      break;
+    }
+    chain.push_back(current);
+    if (frames[current].keyframe) {
+      break;
+    }
+    current = current > 0 ? storedIndex(current - 1) : -1;
+    if (current < 0 || frames[current].size.load(std::memory_order_acquire) == 0) {
+      LOGE("SequenceFile::readFrame() the reference of delta frame %d is missing!", index);
+      return false;
+    }
+  }
+  if (startFromLastFrame) {
+    memcpy(pixels, context->lastFrame.bytes(), byteSize);
+  }
+  for (auto item = chain.rbegin(); item != chain.rend(); item++) {
+    const auto& frame = frames[*item];
+    if (frame.keyframe) {
+      if (!decodeFrame(frame, frame.size, pixels)) {
+        return false;
+      }
+      continue;
+    }
+    if (context->delta.size() < byteSize) {
+      context->delta.alloc(byteSize);
+    }
+    if (context->delta.isEmpty() || !decodeFrame(frame, frame.size, context->delta.bytes())) {
+      return false;
+    }
+    XorPixels(pixels, pixels, context->delta.bytes(), byteSize);
+  }
+  if (context->lastFrame.size() < byteSize) {
+    context->lastFrame.alloc(byteSize);
+  }
+  if (context->lastFrame.isEmpty()) {
+    context->fileID = 0;
+    return true;
+  }
+  memcpy(context->lastFrame.bytes(), pixels, byteSize);
+  context->fileID = uniqueID;
+  context->index = storedIndex(index);
+  return true;
+}
+
+const void* SequenceFile::mapFrame(int index) {
+  if (compressionType != CompressionType::None || index < 0 || index >= _numFrames) {
+    return nullptr;
+  }
+  auto mappedFile = getMappedBytes();
+  if (mappedFile == nullptr) {
+    return nullptr;
+  }
+  return mappedFile + frames[index].offset;
+}
+
+uint8_t* SequenceFile::getMappedBytes() {
+  auto bytes = mappedBytes.load(std::memory_order_acquire);
+  if (bytes != nullptr || mappingFailed || cachedFrames != _numFrames) {
+    return bytes;
+  }
+  std::lock_guard<std::mutex> autoLock(locker);
+  bytes = mappedBytes.load(std::memory_order_acquire);
+  if (bytes != nullptr || mappingFailed) {
+    return bytes;
+  }
+  mappedSize = _fileSize;
+  bytes = MapFile(fd, mappedSize);
+  if (bytes == nullptr) {
+    mappingFailed = true;
+    return nullptr;
+  }
+  mappedBytes.store(bytes, std::memory_order_release);
+  return bytes;
+}
+
 bool SequenceFile::writeFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
   std::lock_guard<std::mutex> autoLock(locker);
   if (index < 0 || index >= _numFrames || bitmap == nullptr) {
@@ -274,45 +601,131 @@ bool SequenceFile::writeFrame(int index, std::shared_ptr<BitmapBuffer> bitmap) {
     LOGE("SequenceFile::writeFrame() failed to lock pixels from the specified bitmap!");
     return false;
   }
-  auto compressedSize = compressFrame(static_cast<int>(timeRange.start), pixels, _info.byteSize());
+  auto success = writeFrameInternal(static_cast<int>(timeRange.start), timeRange,
+                                    reinterpret_cast<const uint8_t*>(pixels));
   bitmap->unlockPixels();
-  if (compressedSize == 0) {
+  if (!success) {
     return false;
   }
-  if (_fileSize == 0 && !writeFileHead()) {
+  if (cachedFrames == _numFrames) {
+    scratchBuffer.reset();
+    deltaBuffer.reset();
+    referenceFrames.clear();
+    encoder = nullptr;
+  }
+  if (diskCache) {
+    diskCache->notifyFileSizeChanged(diskCacheShard, fileID, _fileSize);
+  }
+  return true;
+}
+
+bool SequenceFile::writeFrameInternal(int index, const TimeRange& timeRange,
+                                      const uint8_t* pixels) {
+  auto byteSize = _info.byteSize();
+  auto framePixels = pixels;
+  ReferenceFrame* reference = nullptr;
+  if (compressionType == CompressionType::LZ4_DELTA) {
+    reference = findReferenceFrame(index);
+    if (reference != nullptr) {
+      if (deltaBuffer.isEmpty()) {
+        deltaBuffer.alloc(byteSize);
+      }
+      if (deltaBuffer.isEmpty()) {
+        reference = nullptr;
+      } else {
+        XorPixels(deltaBuffer.bytes(), pixels, reference->pixels.bytes(), byteSize);
+        framePixels = deltaBuffer.bytes();
+      }
+    }
+  }
+  auto keyframe = reference == nullptr;
+  auto compressedSize = compressFrame(index, framePixels, byteSize, keyframe);
+  if (compressedSize == 0) {
     return false;
   }
-  if (fseek(file, 0, SEEK_END)) {
-    LOGE("SequenceFile::writeFrame() failed to seek to the end of the file");
+  if (_fileSize == 0 && !writeFileHead()) {
     return false;
   }
-  if (fwrite(scratchBuffer.bytes(), 1, compressedSize, file) != compressedSize) {
+  size_t fileSize = _fileSize;
+  if (!WriteAt(fd, scratchBuffer.bytes(), compressedSize, fileSize)) {
     LOGE("SequenceFile::writeFrame() failed to write the compressed frame to disk");
     return false;
   }
   for (auto i = timeRange.start; i <= timeRange.end; i++) {
     auto& frame = frames[i];
-    frame.offset = _fileSize + FRAME_HEAD_SIZE;
-    frame.size = compressedSize - FRAME_HEAD_SIZE;
-    cachedFrames++;
+    frame.offset = fileSize + FRAME_HEAD_SIZE;
+    frame.keyframe = keyframe;
+    frame.size.store(compressedSize - FRAME_HEAD_SIZE, std::memory_order_release);
   }
-  _fileSize += compressedSize;
-  if (cachedFrames == _numFrames) {
-    scratchBuffer.reset();
-    encoder = nullptr;
-  }
-  if (diskCache) {
-    diskCache->notifyFileSizeChanged(fileID, _fileSize);
+  cachedFrames += static_cast<int>(timeRange.duration());
+  _fileSize = fileSize + compressedSize;
+  if (compressionType == CompressionType::LZ4_DELTA) {
+    updateReferenceFrames(reference, index, pixels, keyframe);
   }
   return true;
 }
 
-size_t SequenceFile::compressFrame(int index, const void* pixels, size_t byteSize) {
+ReferenceFrame* SequenceFile::findReferenceFrame(int index) {
+  if (index == 0) {
+    return nullptr;
+  }
+  auto previousIndex = storedIndex(index - 1);
+  for (auto& reference : referenceFrames) {
+    if (reference.index == previousIndex) {
+      return reference.chainLength + 1 < KEYFRAME_INTERVAL ? &reference : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+void SequenceFile::updateReferenceFrames(ReferenceFrame* reference, int index,
+                                         const uint8_t* pixels, bool keyframe) {
+  auto chainLength = keyframe ? 0 : reference->chainLength + 1;
+  auto previousIndex = index > 0 ? storedIndex(index - 1) : -1;
+  // Reuses the slot of the previous frame, since the writer of it most likely continues from here.
+  auto slot = referenceFrames.end();
+  for (auto item = referenceFrames.begin(); item != referenceFrames.end(); item++) {
+    if (item->index == previousIndex) {
+      slot = item;
+      break;
+    }
+  }
+  if (slot == referenceFrames.end()) {
+    if (referenceFrames.size() < MAX_REFERENCE_FRAMES) {
+      slot = referenceFrames.emplace(referenceFrames.end());
+    } else {
+      slot = referenceFrames.begin();
+    }
+  }
+  referenceFrames.splice(referenceFrames.end(), referenceFrames, slot);
+  auto byteSize = _info.byteSize();
+  if (slot->pixels.size() < byteSize) {
+    slot->pixels.alloc(byteSize);
+  }
+  if (slot->pixels.isEmpty()) {
+    referenceFrames.erase(slot);
+    return;
+  }
+  memcpy(slot->pixels.bytes(), pixels, byteSize);
+  slot->index = index;
+  slot->chainLength = chainLength;
+}
+
+size_t SequenceFile::compressFrame(int index, const void* pixels, size_t byteSize,
+                                   bool keyframe) {
   if (!checkScratchBuffer()) {
     return 0;
   }
+  tgfx::DataView dataView(scratchBuffer.bytes(), scratchBuffer.size());
+  dataView.setUint32(0, keyframe ? index : index | DELTA_FRAME_FLAG);
+  if (compressionType == CompressionType::None) {
+    memcpy(scratchBuffer.bytes() + FRAME_HEAD_SIZE, pixels, byteSize);
+    dataView.setUint64(4, byteSize);
+    return byteSize + FRAME_HEAD_SIZE;
+  }
   if (encoder == nullptr) {
-    encoder = LZ4Encoder::Make();
+    encoder = compressionType == CompressionType::LZ4_DELTA ? LZ4Encoder::MakeRaw()
+                                                            : LZ4Encoder::Make();
   }
   auto bytes = scratchBuffer.bytes() + FRAME_HEAD_SIZE;
   auto size = scratchBuffer.size() - FRAME_HEAD_SIZE;
@@ -322,8 +735,6 @@ size_t SequenceFile::compressFrame(int index, const void* pixels, size_t byteSiz
     LOGE("SequenceFile::compressFrame() failed to encode frame %d!", index);
     return 0;
   }
-  tgfx::DataView dataView(scratchBuffer.bytes(), scratchBuffer.size());
-  dataView.setUint32(0, index);
   dataView.setUint64(4, encodedLength);
   return encodedLength + FRAME_HEAD_SIZE;
 }
@@ -332,17 +743,12 @@ bool SequenceFile::checkScratchBuffer() {
   if (!scratchBuffer.isEmpty()) {
     return true;
   }
-  size_t scratchBufferSize = 0;
-  if (cachedFrames == _numFrames) {
-    for (auto& frame : frames) {
-      if (frame.size > scratchBufferSize) {
-        scratchBufferSize = frame.size;
-      }
-    }
-  } else {
-    scratchBufferSize = LZ4Encoder::GetMaxOutputSize(_info.byteSize()) + FRAME_HEAD_SIZE;
+  // The scratch buffer is only used by writing, every reading thread has its own buffer.
+  auto byteSize = _info.byteSize();
+  if (compressionType != CompressionType::None) {
+    byteSize = LZ4Encoder::GetMaxOutputSize(byteSize);
   }
-  scratchBuffer.alloc(scratchBufferSize);
+  scratchBuffer.alloc(byteSize + FRAME_HEAD_SIZE);
   if (scratchBuffer.isEmpty()) {
     LOGE("SequenceFile::checkScratchBuffer() failed to alloc scratch buffer!");
     return false;
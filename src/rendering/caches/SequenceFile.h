@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <list>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -30,15 +32,42 @@
 
 namespace pag {
 class DiskCache;
+class DiskCacheShard;
 
 struct FrameLocation {
   size_t offset = 0;
-  size_t size = 0;
+  bool keyframe = true;
+  /**
+   * The size is published after the offset and the frame data are written, a non-zero size means
+   * the frame can be read without locking.
+   */
+  std::atomic<size_t> size = 0;
 };
 
 enum class CompressionType {
+  None = 0,
   LZ4 = 1,
   LZ4_APPLE = 2,
+  /**
+   * Stores periodic keyframes and the XOR deltas against the previous frame for others, both of
+   * which are compressed in the raw LZ4 block format.
+   */
+  LZ4_DELTA = 3,
+};
+
+#ifdef __APPLE__
+static constexpr CompressionType DEFAULT_COMPRESSION_TYPE = CompressionType::LZ4_APPLE;
+#else
+static constexpr CompressionType DEFAULT_COMPRESSION_TYPE = CompressionType::LZ4;
+#endif
+
+/**
+ * A recently written frame which the next frame can be encoded as a delta against.
+ */
+struct ReferenceFrame {
+  int index = -1;
+  int chainLength = 0;
+  tgfx::Buffer pixels = {};
 };
 
 /**
@@ -102,10 +131,18 @@ class SequenceFile {
 
   /**
    * Reads an image frame from the sequence into the specified pixel address. Returns false if the
-   * specified index is empty or the bitmap info is different from ours.
+   * specified index is empty or the bitmap info is different from ours. Reading never blocks other
+   * reading or writing threads.
    */
   bool readFrame(int index, std::shared_ptr<BitmapBuffer> bitmap);
 
+  /**
+   * Returns the pixels of the image frame at the specified index directly from the memory-mapped
+   * sequence file, which stay valid until the sequence file is released. Returns nullptr if the
+   * sequence is not complete yet, the frames are compressed, or the file can not be mapped.
+   */
+  const void* mapFrame(int index);
+
   /**
    * Writes an image frame in the pixel address into the sequence.Returns false if the specified
    * index is not empty or the bitmap info is different from ours, and leave the sequence unchanged.
@@ -113,33 +150,53 @@ class SequenceFile {
   bool writeFrame(int index, std::shared_ptr<BitmapBuffer> bitmap);
 
  private:
+  // Only guards the writing operations, reading operations are lock-free.
   std::mutex locker = {};
   DiskCache* diskCache = nullptr;
+  DiskCacheShard* diskCacheShard = nullptr;
   uint32_t fileID = 0;
-  FILE* file = nullptr;
-  size_t _fileSize = 0;
+  int fd = -1;
+  uint32_t uniqueID = 0;
+  std::atomic<size_t> _fileSize = 0;
   CompressionType compressionType = CompressionType::LZ4;
   tgfx::ImageInfo _info = {};
   int _numFrames = 0;
   float _frameRate = 30.0f;
   std::vector<TimeRange> _staticTimeRanges = {};
-  int cachedFrames = 0;
-  std::vector<FrameLocation> frames = {};
+  std::atomic<int> cachedFrames = 0;
+  std::unique_ptr<FrameLocation[]> frames = nullptr;
+  // The file is mapped into memory once all frames are cached, since it will never change again.
+  std::atomic<uint8_t*> mappedBytes = nullptr;
+  std::atomic_bool mappingFailed = false;
+  size_t mappedSize = 0;
   tgfx::Buffer scratchBuffer = {};
+  tgfx::Buffer deltaBuffer = {};
+  std::list<ReferenceFrame> referenceFrames = {};
   std::unique_ptr<LZ4Decoder> decoder = nullptr;
   std::unique_ptr<LZ4Encoder> encoder = nullptr;
 
-  static std::shared_ptr<SequenceFile> Open(const std::string& filePath,
-                                            const tgfx::ImageInfo& info, int frameCount,
-                                            float frameRate,
-                                            const std::vector<TimeRange>& staticTimeRanges);
+  static std::shared_ptr<SequenceFile> Open(
+      const std::string& filePath, const tgfx::ImageInfo& info, int frameCount, float frameRate,
+      const std::vector<TimeRange>& staticTimeRanges,
+      CompressionType compressionType = DEFAULT_COMPRESSION_TYPE);
 
   SequenceFile(const std::string& filePath, const tgfx::ImageInfo& info, int frameCount,
-               float frameRate, std::vector<TimeRange> staticTimeRanges);
+               float frameRate, std::vector<TimeRange> staticTimeRanges,
+               CompressionType compressionType);
+
+  uint8_t* getMappedBytes();
 
   bool readFramesFromFile();
+  void resetFrames();
   bool writeFileHead();
-  size_t compressFrame(int index, const void* pixels, size_t byteSize);
+  int storedIndex(int index) const;
+  bool decodeFrame(const FrameLocation& frame, size_t frameSize, uint8_t* pixels);
+  bool readDeltaFrame(int index, uint8_t* pixels);
+  bool writeFrameInternal(int index, const TimeRange& timeRange, const uint8_t* pixels);
+  ReferenceFrame* findReferenceFrame(int index);
+  void updateReferenceFrames(ReferenceFrame* reference, int index, const uint8_t* pixels,
+                             bool keyframe);
+  size_t compressFrame(int index, const void* pixels, size_t byteSize, bool keyframe);
   bool checkScratchBuffer();
   bool compatible(const tgfx::ImageInfo& info, int frameCount, float frameRate,
                   const std::vector<TimeRange>& staticTimeRanges);
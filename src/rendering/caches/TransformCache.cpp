@@ -17,9 +17,21 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "TransformCache.h"
+#include <mutex>
 #include "rendering/renderers/TransformRenderer.h"
 
 namespace pag {
+TransformCache* TransformCache::Get(Layer* layer) {
+  // The layer->locker is held while its LayerCache is being created, which takes the transform
+  // cache from here.
+  static auto& locker = *new std::mutex();
+  std::lock_guard<std::mutex> autoLock(locker);
+  if (layer->transformCache == nullptr) {
+    layer->transformCache = new TransformCache(layer);
+  }
+  return static_cast<TransformCache*>(layer->transformCache);
+}
+
 TransformCache::TransformCache(Layer* layer)
     : FrameCache<Transform>(layer->startTime, layer->duration), layer(layer) {
   std::vector<TimeRange> timeRanges = {layer->visibleRange()};
@@ -52,6 +64,16 @@ Transform* TransformCache::createCache(Frame layerFrame) {
   RenderTransform(transform, layer->transform, layerFrame);
   auto parent = layer->parent;
   while (parent != nullptr && parent->transform != nullptr) {
+    auto parentFrame = layerFrame - parent->startTime;
+    if (parentFrame >= 0 && parentFrame < parent->duration) {
+      // The matrix cached by the parent already contains all of its ancestors, so siblings that
+      // share the same parent never compute the ancestors again. Only the transform is cached for
+      // the parent, which may never be drawn by itself.
+      auto parentTransform = Get(parent)->getCache(parentFrame);
+      transform->matrix.postConcat(parentTransform->matrix);
+      break;
+    }
+    // The parent's cache only covers its own duration.
     Transform parentTransform = {};
     RenderTransform(&parentTransform, parent->transform, layerFrame);
     transform->matrix.postConcat(parentTransform.matrix);
@@ -24,6 +24,12 @@
 namespace pag {
 class TransformCache : public FrameCache<Transform> {
  public:
+  /**
+   * Returns the transform cache of the layer, which is shared by its LayerCache and the transform
+   * caches of its children. The layer keeps the ownership.
+   */
+  static TransformCache* Get(Layer* layer);
+
   explicit TransformCache(Layer* layer);
 
  protected:
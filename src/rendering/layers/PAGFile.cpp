@@ -38,6 +38,35 @@ std::shared_ptr<PAGFile> PAGFile::Load(const std::string& filePath) {
   return MakeFrom(file);
 }
 
+std::shared_ptr<PAGFile> PAGFile::LoadMapped(const std::string& filePath) {
+  auto file = File::LoadMapped(filePath);
+  return MakeFrom(file);
+}
+
+void PAGFile::SetLazyDecodingEnabled(bool enabled) {
+  File::SetLazyDecodingEnabled(enabled);
+}
+
+bool PAGFile::LazyDecodingEnabled() {
+  return File::LazyDecodingEnabled();
+}
+
+void PAGFile::SetParallelDecodingEnabled(bool enabled) {
+  File::SetParallelDecodingEnabled(enabled);
+}
+
+bool PAGFile::ParallelDecodingEnabled() {
+  return File::ParallelDecodingEnabled();
+}
+
+void PAGFile::SetKeyframeBakingEnabled(bool enabled) {
+  File::SetKeyframeBakingEnabled(enabled);
+}
+
+bool PAGFile::KeyframeBakingEnabled() {
+  return File::KeyframeBakingEnabled();
+}
+
 std::shared_ptr<PAGFile> PAGFile::MakeFrom(std::shared_ptr<File> file) {
   if (file == nullptr) {
     return nullptr;
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include "base/utils/MatrixUtil.h"
 #include "base/utils/TimeUtil.h"
+#include "rendering/caches/ImageContentCache.h"
 #include "rendering/caches/LayerCache.h"
 #include "rendering/caches/RenderCache.h"
 #include "rendering/editing/ImageReplacement.h"
@@ -83,7 +84,7 @@ void PAGStage::addReference(PAGLayer* pagLayer) {
     addToReferenceMap(composition->uniqueID, pagLayer);
   } else if (pagLayer->layerType() == LayerType::Image) {
     auto imageBytes = static_cast<ImageLayer*>(pagLayer->layer)->imageBytes;
-    addToReferenceMap(imageBytes->uniqueID, pagLayer);
+    addToReferenceMap(ImageContentCache::GetAssetID(imageBytes), pagLayer);
     auto pagImage = static_cast<PAGImageLayer*>(pagLayer)->getPAGImage();
     if (pagImage != nullptr) {
       addReference(pagImage.get(), pagLayer);
@@ -120,7 +121,7 @@ void PAGStage::removeReference(PAGLayer* pagLayer) {
     }
   } else if (pagLayer->layerType() == LayerType::Image) {
     auto imageBytes = static_cast<ImageLayer*>(pagLayer->layer)->imageBytes;
-    removeFromReferenceMap(imageBytes->uniqueID, pagLayer);
+    removeFromReferenceMap(ImageContentCache::GetAssetID(imageBytes), pagLayer);
     auto pagImage = static_cast<PAGImageLayer*>(pagLayer)->getPAGImage();
     if (pagImage != nullptr) {
       removeReference(pagImage.get(), pagLayer);
@@ -177,7 +178,7 @@ void PAGStage::invalidateCacheScale(PAGLayer* pagLayer) {
     invalidIDs.push_back(composition->uniqueID);
   } else if (pagLayer->layerType() == LayerType::Image) {
     auto imageBytes = static_cast<ImageLayer*>(pagLayer->layer)->imageBytes;
-    invalidIDs.push_back(imageBytes->uniqueID);
+    invalidIDs.push_back(ImageContentCache::GetAssetID(imageBytes));
     auto pagImage = static_cast<PAGImageLayer*>(pagLayer)->getPAGImage();
     if (pagImage != nullptr) {
       invalidIDs.push_back(pagImage->uniqueID());
@@ -17,13 +17,18 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "BitmapSequenceReader.h"
-#include "tgfx/core/Buffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include "rendering/utils/FrameBufferPool.h"
 #include "tgfx/core/ImageCodec.h"
 #include "tgfx/core/Pixmap.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
 BitmapSequenceReader::BitmapSequenceReader(std::shared_ptr<File> file, BitmapSequence* sequence)
     : file(std::move(file)), sequence(sequence) {
+  sequence->decodeDeferredFrames();
   // Force allocating a raster PixelBuffer if staticContent is false, otherwise the asynchronous
   // decoding will fail due to the memory sharing mechanism.
   if (tgfx::HardwareBufferAvailable() && sequence->composition->staticContent()) {
@@ -32,9 +37,10 @@ BitmapSequenceReader::BitmapSequenceReader(std::shared_ptr<File> file, BitmapSeq
   }
   if (hardWareBuffer == nullptr) {
     info = tgfx::ImageInfo::Make(sequence->width, sequence->height, tgfx::ColorType::RGBA_8888);
-    tgfx::Buffer buffer(info.byteSize());
-    buffer.clear();
-    pixels = buffer.release();
+    pixels = FrameBufferPool::Get()->makeData(info.byteSize());
+    if (pixels != nullptr) {
+      memset(const_cast<void*>(pixels->data()), 0, pixels->size());
+    }
   }
 }
 
@@ -53,6 +59,8 @@ std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::onMakeBuffer(Frame targ
   if (hardWareBuffer == nullptr && pixels == nullptr) {
     return nullptr;
   }
+  // Continues from the last decoded frame if no key frame is closer to the target frame.
+  auto startFrame = findStartFrame(targetFrame);
   imageBuffer = nullptr;
   lastDecodeFrame = -1;
   tgfx::Pixmap pixmap = {};
@@ -65,34 +73,10 @@ std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::onMakeBuffer(Frame targ
   } else {
     pixmap.reset(info, const_cast<void*>(pixels->data()));
   }
-  auto startFrame = findStartFrame(targetFrame);
-  auto& bitmapFrames = static_cast<BitmapSequence*>(sequence)->frames;
-  for (Frame frame = startFrame; frame <= targetFrame; frame++) {
-    auto bitmapFrame = bitmapFrames[frame];
-    auto firstRead = true;
-    for (auto bitmapRect : bitmapFrame->bitmaps) {
-      auto imageBytes = tgfx::Data::MakeWithoutCopy(bitmapRect->fileBytes->data(),
-                                                    bitmapRect->fileBytes->length());
-      auto codec = tgfx::ImageCodec::MakeFrom(imageBytes);
-      // The returned image could be nullptr if the frame is an empty frame.
-      if (codec != nullptr) {
-        if (firstRead && bitmapFrame->isKeyframe &&
-            !(codec->width() == pixmap.width() && codec->height() == pixmap.height())) {
-          // clear the whole screen if the size of the key frame is smaller than the screen.
-          pixmap.clear();
-        }
-        auto offset = pixmap.rowBytes() * bitmapRect->y + bitmapRect->x * 4;
-        auto info = tgfx::ImageInfo::Make(codec->width(), codec->height(), pixmap.colorType(),
-                                          pixmap.alphaType(), pixmap.rowBytes());
-        auto result =
-            codec->readPixels(info, reinterpret_cast<uint8_t*>(pixmap.writablePixels()) + offset);
-        if (!result) {
-          tgfx::HardwareBufferUnlock(hardWareBuffer);
-          return nullptr;
-        }
-        firstRead = false;
-      }
-    }
+  auto result = decodeFrames(startFrame, targetFrame, &pixmap);
+  if (!result) {
+    tgfx::HardwareBufferUnlock(hardWareBuffer);
+    return nullptr;
   }
   if (hardWareBuffer) {
     tgfx::HardwareBufferUnlock(hardWareBuffer);
@@ -105,6 +89,108 @@ std::shared_ptr<tgfx::ImageBuffer> BitmapSequenceReader::onMakeBuffer(Frame targ
   return imageBuffer;
 }
 
+struct DecodingRect {
+  std::shared_ptr<tgfx::ImageCodec> codec = nullptr;
+  int x = 0;
+  int y = 0;
+
+  bool contains(const DecodingRect& other) const {
+    return x <= other.x && y <= other.y && x + codec->width() >= other.x + other.codec->width() &&
+           y + codec->height() >= other.y + other.codec->height();
+  }
+
+  bool intersects(const DecodingRect& other) const {
+    return x < other.x + other.codec->width() && other.x < x + codec->width() &&
+           y < other.y + other.codec->height() && other.y < y + codec->height();
+  }
+};
+
+static bool ReadRect(const DecodingRect& rect, tgfx::Pixmap* pixmap) {
+  auto offset = pixmap->rowBytes() * rect.y + rect.x * 4;
+  auto info = tgfx::ImageInfo::Make(rect.codec->width(), rect.codec->height(), pixmap->colorType(),
+                                    pixmap->alphaType(), pixmap->rowBytes());
+  auto pixels = reinterpret_cast<uint8_t*>(pixmap->writablePixels()) + offset;
+  return rect.codec->readPixels(info, pixels);
+}
+
+static bool ReadRects(const std::vector<DecodingRect>& rects, tgfx::Pixmap* pixmap) {
+  if (rects.size() == 1) {
+    return ReadRect(rects[0], pixmap);
+  }
+  // The rects are disjoint, so they are written to the pixmap concurrently.
+  std::vector<std::shared_ptr<tgfx::Task>> tasks = {};
+  std::atomic_bool success = {true};
+  for (size_t i = 1; i < rects.size(); i++) {
+    auto& rect = rects[i];
+    tasks.push_back(tgfx::Task::Run([&rect, pixmap, &success]() {
+      if (!ReadRect(rect, pixmap)) {
+        success = false;
+      }
+    }));
+  }
+  if (!ReadRect(rects[0], pixmap)) {
+    success = false;
+  }
+  for (auto& task : tasks) {
+    task->wait();
+  }
+  return success;
+}
+
+bool BitmapSequenceReader::decodeFrames(Frame startFrame, Frame targetFrame,
+                                        tgfx::Pixmap* pixmap) {
+  auto& bitmapFrames = static_cast<BitmapSequence*>(sequence)->frames;
+  // Walks backwards from the target frame and skips the rects overwritten by the later ones, only
+  // the rects still visible at the target frame are decoded.
+  std::vector<DecodingRect> rects = {};
+  std::shared_ptr<tgfx::ImageCodec> keyframeCodec = nullptr;
+  for (Frame frame = targetFrame; frame >= startFrame; frame--) {
+    auto bitmapFrame = bitmapFrames[frame];
+    auto& bitmaps = bitmapFrame->bitmaps;
+    for (auto iter = bitmaps.rbegin(); iter != bitmaps.rend(); iter++) {
+      auto bitmapRect = *iter;
+      auto imageBytes = tgfx::Data::MakeWithoutCopy(bitmapRect->fileBytes->data(),
+                                                    bitmapRect->fileBytes->length());
+      DecodingRect rect = {tgfx::ImageCodec::MakeFrom(imageBytes), bitmapRect->x, bitmapRect->y};
+      // The codec could be nullptr if the frame is an empty frame.
+      if (rect.codec == nullptr) {
+        continue;
+      }
+      if (frame == startFrame && bitmapFrame->isKeyframe) {
+        // Ends with the first rect of the key frame.
+        keyframeCodec = rect.codec;
+      }
+      auto covered = std::any_of(rects.begin(), rects.end(), [&rect](const DecodingRect& later) {
+        return later.contains(rect);
+      });
+      if (!covered) {
+        rects.push_back(std::move(rect));
+      }
+    }
+  }
+  std::reverse(rects.begin(), rects.end());
+  if (keyframeCodec != nullptr &&
+      (keyframeCodec->width() != pixmap->width() || keyframeCodec->height() != pixmap->height())) {
+    // clear the whole screen if the size of the key frame is smaller than the screen.
+    pixmap->clear();
+  }
+  // Groups the rects into batches of disjoint ones, the overlapped rects are kept in order.
+  std::vector<DecodingRect> batch = {};
+  for (auto& rect : rects) {
+    auto overlapped = std::any_of(batch.begin(), batch.end(), [&rect](const DecodingRect& other) {
+      return other.intersects(rect);
+    });
+    if (overlapped) {
+      if (!ReadRects(batch, pixmap)) {
+        return false;
+      }
+      batch.clear();
+    }
+    batch.push_back(rect);
+  }
+  return batch.empty() || ReadRects(batch, pixmap);
+}
+
 void BitmapSequenceReader::onReportPerformance(Performance* performance, int64_t decodingTime) {
   performance->imageDecodingTime += decodingTime;
 }
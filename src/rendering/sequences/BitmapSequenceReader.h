@@ -22,6 +22,7 @@
 #include "pag/file.h"
 #include "rendering/Performance.h"
 #include "tgfx/core/Bitmap.h"
+#include "tgfx/core/Pixmap.h"
 
 namespace pag {
 class BitmapSequenceReader : public SequenceReader {
@@ -36,6 +37,11 @@ class BitmapSequenceReader : public SequenceReader {
     return sequence->height;
   }
 
+  size_t maxBufferCount() const override {
+    // The raster buffers are copied out of the pixels by the codec.
+    return hardWareBuffer != nullptr ? 1 : 0;
+  }
+
   ~BitmapSequenceReader() override;
 
  protected:
@@ -45,6 +51,8 @@ class BitmapSequenceReader : public SequenceReader {
 
   Frame findStartFrame(Frame targetFrame);
 
+  bool decodeFrames(Frame startFrame, Frame targetFrame, tgfx::Pixmap* pixmap);
+
   std::mutex locker = {};
   // Keep a reference to the File in case the Sequence object is released while we are using it.
   std::shared_ptr<File> file = nullptr;
@@ -18,9 +18,10 @@
 
 #include "DiskSequenceReader.h"
 #include <tgfx/core/ImageCodec.h>
+#include <cstring>
 #include "base/utils/TGFXCast.h"
 #include "platform/Platform.h"
-#include "tgfx/core/Buffer.h"
+#include "rendering/utils/FrameBufferPool.h"
 #include "tgfx/core/ImageCodec.h"
 
 namespace pag {
@@ -54,6 +55,12 @@ int DiskSequenceReader::height() const {
   return sequence->composition->height;
 }
 
+size_t DiskSequenceReader::maxBufferCount() const {
+  // The hardware buffers are allocated on the first read and rendered to in turns, while the raster
+  // buffers are copied out of the pixels by the codec.
+  return tgfx::HardwareBufferAvailable() ? 2 : 0;
+}
+
 std::shared_ptr<tgfx::ImageBuffer> DiskSequenceReader::onMakeBuffer(Frame targetFrame) {
   // Need a locker here in case there are other threads are decoding at the same time.
   std::lock_guard<std::mutex> autoLock(locker);
@@ -90,9 +97,10 @@ std::shared_ptr<tgfx::ImageBuffer> DiskSequenceReader::onMakeBuffer(Frame target
     if (frontHardWareBuffer == nullptr) {
       info = tgfx::ImageInfo::Make(pagDecoder->width(), pagDecoder->height(),
                                    tgfx::ColorType::RGBA_8888);
-      tgfx::Buffer buffer(info.byteSize());
-      buffer.clear();
-      pixels = buffer.release();
+      pixels = FrameBufferPool::Get()->makeData(info.byteSize());
+      if (pixels != nullptr) {
+        memset(const_cast<void*>(pixels->data()), 0, pixels->size());
+      }
     }
   }
 
@@ -29,6 +29,8 @@ class DiskSequenceReader : public SequenceReader {
 
   int height() const override;
 
+  size_t maxBufferCount() const override;
+
   ~DiskSequenceReader() override;
 
  private:
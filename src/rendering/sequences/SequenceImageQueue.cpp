@@ -17,10 +17,12 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SequenceImageQueue.h"
+#include <algorithm>
 
 namespace pag {
 std::unique_ptr<SequenceImageQueue> SequenceImageQueue::MakeFrom(
-    std::shared_ptr<SequenceInfo> sequence, PAGLayer* pagLayer, bool useDiskCache) {
+    std::shared_ptr<SequenceInfo> sequence, PAGLayer* pagLayer, bool useDiskCache,
+    size_t maxQueueSize, size_t memoryLimit) {
   if (sequence == nullptr || pagLayer == nullptr || sequence->staticContent()) {
     return nullptr;
   }
@@ -28,57 +30,276 @@ std::unique_ptr<SequenceImageQueue> SequenceImageQueue::MakeFrom(
   if (reader == nullptr) {
     return nullptr;
   }
+  auto queueSize = std::max(maxQueueSize, static_cast<size_t>(1));
+  auto frameBytes = static_cast<size_t>(reader->width() * reader->height()) * 4;
+  if (memoryLimit > 0 && frameBytes > 0) {
+    queueSize = std::clamp(memoryLimit / frameBytes, static_cast<size_t>(1), queueSize);
+  }
+  if (queueSize > 1) {
+    reader->enableBufferCopies();
+  }
   auto firstFrame = sequence->firstVisibleFrame(pagLayer->getLayer());
   return std::unique_ptr<SequenceImageQueue>(
-      new SequenceImageQueue(sequence, std::move(reader), firstFrame, useDiskCache));
+      new SequenceImageQueue(sequence, std::move(reader), firstFrame, useDiskCache, queueSize,
+                             frameBytes));
 }
 
 SequenceImageQueue::SequenceImageQueue(std::shared_ptr<SequenceInfo> sequence,
                                        std::shared_ptr<SequenceReader> reader, Frame firstFrame,
-                                       bool useDiskCache)
+                                       bool useDiskCache, size_t queueSize, size_t frameBytes)
     : sequence(sequence), reader(std::move(reader)), firstFrame(firstFrame),
-      totalFrames(sequence->duration()), useDiskCache(useDiskCache) {
+      totalFrames(sequence->duration()), useDiskCache(useDiskCache), frameBytes(frameBytes),
+      queuedFrames(queueSize) {
 }
 
-void SequenceImageQueue::prepareNextImage() {
-  auto nextFrame = currentFrame + 1;
-  if (nextFrame >= totalFrames) {
-    nextFrame = firstFrame;
+SequenceImageQueue::~SequenceImageQueue() {
+  releaseQueuedFrames();
+  // The background task stops after the frame it is decoding, since no frame is pending now.
+  if (task != nullptr) {
+    task->wait();
   }
-  prepare(nextFrame);
+}
+
+void SequenceImageQueue::prepareNextImage() {
+  auto step = direction;
+  prepare(nextFrame(currentFrame, &step));
 }
 
 void SequenceImageQueue::prepare(Frame targetFrame) {
-  if (preparedImage != nullptr || targetFrame < 0 || targetFrame >= totalFrames) {
+  if (targetFrame < 0 || targetFrame >= totalFrames) {
+    return;
+  }
+  std::vector<Frame> frames = {};
+  auto maxFrames = maxQueuedFrames();
+  auto step = direction;
+  auto frame = targetFrame;
+  for (size_t i = 0; i <= maxFrames && frames.size() < maxFrames; i++) {
+    if (frame < 0 || frame >= totalFrames ||
+        std::find(frames.begin(), frames.end(), frame) != frames.end()) {
+      break;
+    }
+    if (frame != currentFrame) {
+      frames.push_back(frame);
+    }
+    frame = nextFrame(frame, &step);
+  }
+  if (frames.empty()) {
     return;
   }
-  auto image = sequence->makeFrameImage(reader, targetFrame, useDiskCache);
-  preparedImage = image->makeDecoded();
   preparedFrame = targetFrame;
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    for (auto& item : queuedFrames) {
+      auto result = std::find(frames.begin(), frames.end(), item.frame);
+      if (result != frames.end()) {
+        item.order = static_cast<size_t>(result - frames.begin());
+      } else if (!item.decoding) {
+        // The frame is out of the new lookahead window, drops it to make room for others.
+        item.frame = -1;
+        item.buffer = nullptr;
+      }
+    }
+    for (size_t i = 0; i < frames.size(); i++) {
+      auto queued = std::find_if(queuedFrames.begin(), queuedFrames.end(),
+                                 [&](const QueuedFrame& item) { return item.frame == frames[i]; });
+      if (queued != queuedFrames.end()) {
+        continue;
+      }
+      auto emptySlot =
+          std::find_if(queuedFrames.begin(), queuedFrames.end(),
+                       [](const QueuedFrame& item) { return item.frame < 0 && !item.decoding; });
+      if (emptySlot == queuedFrames.end()) {
+        break;
+      }
+      emptySlot->frame = frames[i];
+      emptySlot->order = i;
+    }
+    auto hasPendingFrames =
+        std::any_of(queuedFrames.begin(), queuedFrames.end(), [](const QueuedFrame& item) {
+          return item.frame >= 0 && item.buffer == nullptr && !item.decoding;
+        });
+    if (!hasPendingFrames || taskRunning) {
+      return;
+    }
+    taskRunning = true;
+  }
+#ifdef PAG_BUILD_FOR_WEB
+  // There are no background threads on the web platform.
+  decodeFrames();
+#else
+  task = tgfx::Task::Run([this]() { decodeFrames(); });
+#endif
 }
 
 std::shared_ptr<tgfx::Image> SequenceImageQueue::getImage(Frame targetFrame) {
   if (targetFrame == currentFrame) {
     return currentImage;
   }
-  if (targetFrame == preparedFrame) {
-    currentImage = preparedImage;
-    preparedImage = nullptr;
-    currentFrame = preparedFrame;
-    return currentImage;
-  }
-  auto image = sequence->makeFrameImage(reader, targetFrame, useDiskCache);
-  if (image == nullptr) {
-    return nullptr;
+  updateDirection(targetFrame);
+  std::shared_ptr<tgfx::Image> image = nullptr;
+  auto buffer = takeBuffer(targetFrame);
+  if (buffer != nullptr) {
+    image = sequence->makeFrameImage(std::move(buffer), useDiskCache);
+  } else {
+    // Reads the frame right now instead of deferring it to the image, so that it never runs
+    // alongside the background task on the same reader.
+    image = sequence->makeFrameImage(readBuffer(targetFrame), useDiskCache);
+    if (image == nullptr) {
+      return nullptr;
+    }
+    preparedFrame = targetFrame;
   }
-  currentImage = image->makeDecoded();
-  preparedImage = nullptr;
+  currentImage = image;
   currentFrame = targetFrame;
-  preparedFrame = targetFrame;
   return currentImage;
 }
 
 void SequenceImageQueue::reportPerformance(Performance* performance) {
   reader->reportPerformance(performance);
 }
+
+size_t SequenceImageQueue::memoryUsage() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  size_t count = 0;
+  for (auto& item : queuedFrames) {
+    if (item.buffer != nullptr || item.decoding) {
+      count++;
+    }
+  }
+  return count * frameBytes;
+}
+
+size_t SequenceImageQueue::releaseQueuedFrames() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  size_t count = 0;
+  for (auto& item : queuedFrames) {
+    if (item.decoding) {
+      continue;
+    }
+    if (item.buffer != nullptr) {
+      count++;
+    }
+    item.frame = -1;
+    item.buffer = nullptr;
+  }
+  return count * frameBytes;
+}
+
+bool SequenceImageQueue::isDecoding() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return taskRunning;
+}
+
+void SequenceImageQueue::updateDirection(Frame targetFrame) {
+  if (currentFrame < 0) {
+    return;
+  }
+  auto distance = targetFrame - currentFrame;
+  if (distance * 2 > totalFrames || distance * 2 < -totalFrames) {
+    // Jumps across the ends of the sequence, the playback loops.
+    bounceAtEnds = false;
+    return;
+  }
+  auto newDirection = distance > 0 ? 1 : -1;
+  if (newDirection != direction) {
+    // Turning around at either end of the sequence means the playback is ping-pong.
+    bounceAtEnds = currentFrame == 0 || currentFrame == totalFrames - 1;
+    direction = newDirection;
+  }
+}
+
+size_t SequenceImageQueue::maxQueuedFrames() const {
+  auto bufferCount = reader->maxBufferCount();
+  if (bufferCount == 0) {
+    return queuedFrames.size();
+  }
+  // The current image holds one of the buffers, queuing more frames than the rest would overwrite
+  // the ones not displayed yet.
+  return std::clamp(bufferCount - 1, static_cast<size_t>(1), queuedFrames.size());
+}
+
+Frame SequenceImageQueue::nextFrame(Frame frame, int* step) const {
+  auto next = frame + *step;
+  if (next >= 0 && next < totalFrames) {
+    return next;
+  }
+  if (bounceAtEnds) {
+    *step = -*step;
+    return frame + *step;
+  }
+  return *step > 0 ? firstFrame : totalFrames - 1;
+}
+
+std::shared_ptr<tgfx::ImageBuffer> SequenceImageQueue::takeBuffer(Frame targetFrame) {
+  std::unique_lock<std::mutex> autoLock(locker);
+  auto result = std::find_if(queuedFrames.begin(), queuedFrames.end(),
+                             [&](const QueuedFrame& item) { return item.frame == targetFrame; });
+  if (result == queuedFrames.end()) {
+    return nullptr;
+  }
+  auto& queued = *result;
+  if (queued.buffer == nullptr && !queued.decoding) {
+    // Moves the frame to the head of the pending frames, so it is decoded next.
+    for (auto& item : queuedFrames) {
+      item.order++;
+    }
+    queued.order = 0;
+  }
+  condition.wait(autoLock,
+                 [&]() { return queued.buffer != nullptr || queued.frame != targetFrame; });
+  if (queued.frame != targetFrame) {
+    // Failed to decode the frame in the background.
+    return nullptr;
+  }
+  auto buffer = std::move(queued.buffer);
+  queued.buffer = nullptr;
+  queued.frame = -1;
+  return buffer;
+}
+
+std::shared_ptr<tgfx::ImageBuffer> SequenceImageQueue::readBuffer(Frame targetFrame) {
+  std::unique_lock<std::mutex> autoLock(locker);
+  // Waits for the frame being decoded in the background, and keeps the background task from
+  // starting the next one until this read finishes.
+  condition.wait(autoLock, [&]() { return !readerBusy; });
+  readerBusy = true;
+  autoLock.unlock();
+  auto buffer = reader->readBuffer(targetFrame);
+  autoLock.lock();
+  readerBusy = false;
+  condition.notify_all();
+  return buffer;
+}
+
+void SequenceImageQueue::decodeFrames() {
+  std::unique_lock<std::mutex> autoLock(locker);
+  while (true) {
+    condition.wait(autoLock, [&]() { return !readerBusy; });
+    QueuedFrame* next = nullptr;
+    for (auto& item : queuedFrames) {
+      if (item.frame >= 0 && item.buffer == nullptr && !item.decoding &&
+          (next == nullptr || item.order < next->order)) {
+        next = &item;
+      }
+    }
+    if (next == nullptr) {
+      break;
+    }
+    // The slot being decoded is never reassigned, so it is safe to access it after unlocking.
+    next->decoding = true;
+    readerBusy = true;
+    auto frame = next->frame;
+    autoLock.unlock();
+    auto buffer = reader->readBuffer(frame);
+    autoLock.lock();
+    readerBusy = false;
+    next->decoding = false;
+    next->buffer = buffer;
+    if (buffer == nullptr) {
+      next->frame = -1;
+    }
+    condition.notify_all();
+  }
+  taskRunning = false;
+}
 }  // namespace pag
@@ -18,24 +18,49 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
 #include "SequenceInfo.h"
 #include "SequenceReader.h"
 #include "pag/file.h"
 #include "pag/pag.h"
+#include "tgfx/core/Task.h"
 
 namespace pag {
+/**
+ * A slot in the lookahead ring of SequenceImageQueue.
+ */
+struct QueuedFrame {
+  Frame frame = -1;
+  // The position of the frame in the current lookahead window, smaller ones are decoded first.
+  size_t order = 0;
+  bool decoding = false;
+  std::shared_ptr<tgfx::ImageBuffer> buffer = nullptr;
+};
+
 class SequenceImageQueue {
  public:
+  /**
+   * Creates a queue that decodes at most maxQueueSize frames ahead of the current frame. If the
+   * memoryLimit is greater than 0, the queue size is also limited to the number of decoded frames
+   * that fit in memoryLimit bytes. The frames queued are also limited to the buffers the reader can
+   * hand out at the same time. At least one frame is always prepared.
+   */
   static std::unique_ptr<SequenceImageQueue> MakeFrom(std::shared_ptr<SequenceInfo> sequence,
-                                                      PAGLayer* pagLayer, bool useDiskCache);
+                                                      PAGLayer* pagLayer, bool useDiskCache,
+                                                      size_t maxQueueSize = 1,
+                                                      size_t memoryLimit = 0);
+
+  ~SequenceImageQueue();
 
   /**
-   * Prepares the image of the next frame.
+   * Prepares the images of the next frames in the current playing direction.
    */
   void prepareNextImage();
 
   /**
-   * Prepares the image of the specified frame.
+   * Prepares the images of the specified frame and the frames following it in the current playing
+   * direction. The images are decoded asynchronously in playing order by a background task.
    */
   void prepare(Frame targetFrame);
 
@@ -49,6 +74,29 @@ class SequenceImageQueue {
    */
   void reportPerformance(Performance* performance);
 
+  /**
+   * Returns the memory usage of the prefetched frames in bytes.
+   */
+  size_t memoryUsage();
+
+  /**
+   * Releases all prefetched frames that are not being decoded, returns the memory released in
+   * bytes.
+   */
+  size_t releaseQueuedFrames();
+
+  /**
+   * Returns true if the background task is decoding frames.
+   */
+  bool isDecoding();
+
+  /**
+   * Returns the longest time in microseconds that the queue took to decode a frame.
+   */
+  int64_t decodingCost() const {
+    return reader->maxDecodingTime();
+  }
+
  private:
   std::shared_ptr<SequenceInfo> sequence = nullptr;
   std::shared_ptr<SequenceReader> reader = nullptr;
@@ -57,11 +105,29 @@ class SequenceImageQueue {
   Frame currentFrame = -1;
   Frame preparedFrame = -1;
   std::shared_ptr<tgfx::Image> currentImage = nullptr;
-  std::shared_ptr<tgfx::Image> preparedImage = nullptr;
   bool useDiskCache = false;
+  size_t frameBytes = 0;
+  // 1 for forward playback, -1 for reverse playback.
+  int direction = 1;
+  // True if the playback turns around at both ends of the sequence instead of looping.
+  bool bounceAtEnds = false;
+  std::mutex locker = {};
+  std::condition_variable condition = {};
+  std::vector<QueuedFrame> queuedFrames = {};
+  std::shared_ptr<tgfx::Task> task = nullptr;
+  bool taskRunning = false;
+  // True while a frame is being read from the reader, which is not thread-safe.
+  bool readerBusy = false;
 
   SequenceImageQueue(std::shared_ptr<SequenceInfo> sequence, std::shared_ptr<SequenceReader> reader,
-                     Frame firstFrame, bool useDiskCache);
+                     Frame firstFrame, bool useDiskCache, size_t queueSize, size_t frameBytes);
+
+  void updateDirection(Frame targetFrame);
+  size_t maxQueuedFrames() const;
+  Frame nextFrame(Frame frame, int* step) const;
+  std::shared_ptr<tgfx::ImageBuffer> takeBuffer(Frame targetFrame);
+  std::shared_ptr<tgfx::ImageBuffer> readBuffer(Frame targetFrame);
+  void decodeFrames();
 
   friend class RenderCache;
 };
@@ -27,9 +27,11 @@
 #endif
 
 namespace pag {
-static std::shared_ptr<tgfx::Image> MakeSequenceImage(
-    std::shared_ptr<tgfx::ImageGenerator> generator, Sequence* sequence, bool useDiskCache) {
-  auto image = tgfx::Image::MakeFrom(std::move(generator));
+static std::shared_ptr<tgfx::Image> MakeSequenceImage(std::shared_ptr<tgfx::Image> image,
+                                                      Sequence* sequence, bool useDiskCache) {
+  if (image == nullptr) {
+    return nullptr;
+  }
   if (!useDiskCache && sequence->composition->type() == CompositionType::Video) {
     auto videoSequence = static_cast<VideoSequence*>(sequence);
     image = image->makeRGBAAA(sequence->width, sequence->height, videoSequence->alphaStartX,
@@ -93,7 +95,7 @@ std::shared_ptr<tgfx::Image> SequenceInfo::makeStaticImage(std::shared_ptr<File>
   }
   auto generator = std::make_shared<StaticSequenceGenerator>(std::move(file), weakThis.lock(),
                                                              width, height, useDiskCache);
-  return MakeSequenceImage(std::move(generator), sequence, useDiskCache);
+  return MakeSequenceImage(tgfx::Image::MakeFrom(std::move(generator)), sequence, useDiskCache);
 }
 
 std::shared_ptr<tgfx::Image> SequenceInfo::makeFrameImage(std::shared_ptr<SequenceReader> reader,
@@ -102,7 +104,15 @@ std::shared_ptr<tgfx::Image> SequenceInfo::makeFrameImage(std::shared_ptr<Sequen
     return nullptr;
   }
   auto generator = std::make_shared<SequenceFrameGenerator>(std::move(reader), targetFrame);
-  return MakeSequenceImage(std::move(generator), sequence, useDiskCache);
+  return MakeSequenceImage(tgfx::Image::MakeFrom(std::move(generator)), sequence, useDiskCache);
+}
+
+std::shared_ptr<tgfx::Image> SequenceInfo::makeFrameImage(
+    std::shared_ptr<tgfx::ImageBuffer> imageBuffer, bool useDiskCache) {
+  if (imageBuffer == nullptr || sequence == nullptr) {
+    return nullptr;
+  }
+  return MakeSequenceImage(tgfx::Image::MakeFrom(std::move(imageBuffer)), sequence, useDiskCache);
 }
 
 bool SequenceInfo::staticContent() const {
@@ -38,6 +38,8 @@ class SequenceInfo {
                                                        bool useDiskCache);
   virtual std::shared_ptr<tgfx::Image> makeFrameImage(std::shared_ptr<SequenceReader> reader,
                                                       Frame targetFrame, bool useDiskCache);
+  virtual std::shared_ptr<tgfx::Image> makeFrameImage(
+      std::shared_ptr<tgfx::ImageBuffer> imageBuffer, bool useDiskCache);
 
   virtual bool staticContent() const;
   virtual ID uniqueID() const;
@@ -26,7 +26,11 @@ namespace pag {
 std::shared_ptr<tgfx::ImageBuffer> SequenceReader::readBuffer(Frame targetFrame) {
   tgfx::Clock clock = {};
   auto buffer = onMakeBuffer(targetFrame);
-  decodingTime += clock.measure();
+  auto time = clock.measure();
+  decodingTime += time;
+  if (time > _maxDecodingTime) {
+    _maxDecodingTime = time;
+  }
   return buffer;
 }
 
@@ -44,8 +44,33 @@ class SequenceReader {
    */
   std::shared_ptr<tgfx::ImageBuffer> readBuffer(Frame targetFrame);
 
+  /**
+   * Returns how many buffers returned by readBuffer() keep their pixels at the same time. A reader
+   * that decodes into a fixed set of surfaces overwrites the oldest one on each read. Returns 0 if
+   * every returned buffer owns its pixels.
+   */
+  virtual size_t maxBufferCount() const {
+    return 1;
+  }
+
+  /**
+   * Asks the reader to return buffers that keep their pixels after the next reads, so that more of
+   * them can be held at the same time. Readers that decode into a fixed set of surfaces copy every
+   * frame to do so, which is skipped unless requested.
+   */
+  virtual void enableBufferCopies() {
+  }
+
   void reportPerformance(Performance* performance);
 
+  /**
+   * Returns the longest time in microseconds that the reader took to decode a frame, which usually
+   * includes the initialization of the decoder for the first frame.
+   */
+  int64_t maxDecodingTime() const {
+    return _maxDecodingTime;
+  }
+
  protected:
   /**
    * Return the decoded ImageBuffer of the specified frame.
@@ -59,5 +84,6 @@ class SequenceReader {
 
  private:
   std::atomic_int64_t decodingTime = 0;
+  std::atomic_int64_t _maxDecodingTime = 0;
 };
 }  // namespace pag
@@ -18,6 +18,7 @@
 
 #include "VideoReader.h"
 #include "base/utils/TimeUtil.h"
+#include "pag/pag.h"
 #include "platform/Platform.h"
 #include "tgfx/core/Clock.h"
 #ifdef PAG_BUILD_FOR_WEB
@@ -33,6 +34,8 @@ VideoReader::VideoReader(std::unique_ptr<VideoDemuxer> videoDemuxer)
     : demuxer(videoDemuxer.release()) {
   auto videoFormat = demuxer->getFormat();
   frameRate = videoFormat.frameRate;
+  // The size of an I420 frame without padding, the decoders may pad the rows of the copies.
+  frameBytes = static_cast<size_t>(videoFormat.width * videoFormat.height) * 3 / 2;
   // Force using software decoders only when external decoders are available, because the built-in
   // libavc has poor performance.
   if ((demuxer->staticContent() || videoFormat.width * videoFormat.height <= FORCE_SOFTWARE_SIZE) &&
@@ -54,7 +57,12 @@ std::shared_ptr<tgfx::ImageBuffer> VideoReader::onMakeBuffer(Frame targetFrame)
   if (sampleTime == currentRenderedTime) {
     return lastBuffer;
   }
-  lastBuffer = nullptr;
+  lastBuffer = getCachedFrame(sampleTime);
+  if (lastBuffer != nullptr) {
+    // Served from the seek cache, the decoder stays where it is for the frames after it.
+    currentRenderedTime = sampleTime;
+    return lastBuffer;
+  }
   currentRenderedTime = INT64_MIN;
   if (!checkVideoDecoder()) {
     return nullptr;
@@ -78,7 +86,15 @@ std::shared_ptr<tgfx::ImageBuffer> VideoReader::onMakeBuffer(Frame targetFrame)
     return nullptr;
   }
   if (!outputEndOfStream) {
-    lastBuffer = videoDecoder->onRenderFrame();
+    lastBuffer = getCachedFrame(currentDecodedTime);
+    if (lastBuffer == nullptr && bufferCount == 0) {
+      // The frame is queued with others, copies it before the decoder overwrites it.
+      size_t byteSize = 0;
+      lastBuffer = videoDecoder->onCopyFrame(&byteSize);
+    }
+    if (lastBuffer == nullptr) {
+      lastBuffer = videoDecoder->onRenderFrame();
+    }
     if (lastBuffer) {
       currentRenderedTime = currentDecodedTime;
     }
@@ -145,6 +161,7 @@ bool VideoReader::decodeFrame(int64_t sampleTime) {
     } else if (result == DecodingResult::Success) {
       tryDecodeCount = 0;
       currentDecodedTime = videoDecoder->presentationTime();
+      cacheDecodedFrame(sampleTime);
     } else if (result == DecodingResult::EndOfStream) {
       outputEndOfStream = true;
       return true;
@@ -164,6 +181,7 @@ bool VideoReader::checkVideoDecoder() {
   }
   videoDecoder = makeVideoDecoder().release();
   if (videoDecoder) {
+    bufferCount = copyFrames && videoDecoder->canCopyFrames() ? 0 : 1;
 #ifdef PAG_BUILD_FOR_WEB
     auto tmpDemuxer = static_cast<WebVideoSequenceDemuxer*>(demuxer);
     tmpDemuxer->setForHardwareDecoder(videoDecoder->isHardwareBacked());
@@ -179,6 +197,7 @@ void VideoReader::destroyVideoDecoder() {
   }
   delete videoDecoder;
   videoDecoder = nullptr;
+  bufferCount = 1;
   lastBuffer = nullptr;
   currentRenderedTime = INT64_MIN;
   resetParams();
@@ -192,6 +211,51 @@ void VideoReader::resetParams() {
   demuxer->reset();
 }
 
+std::shared_ptr<tgfx::ImageBuffer> VideoReader::getCachedFrame(int64_t sampleTime) {
+  if (seekCache.empty()) {
+    return nullptr;
+  }
+  if (PAGVideoDecoder::MaxSeekCacheBytes() < frameBytes) {
+    clearSeekCache();
+    return nullptr;
+  }
+  auto result = seekCache.find(sampleTime);
+  return result != seekCache.end() ? result->second.buffer : nullptr;
+}
+
+void VideoReader::cacheDecodedFrame(int64_t targetTime) {
+  auto maxBytes = PAGVideoDecoder::MaxSeekCacheBytes();
+  if (frameBytes == 0 || maxBytes < frameBytes) {
+    clearSeekCache();
+    return;
+  }
+  if (seekCache.count(currentDecodedTime) > 0) {
+    return;
+  }
+  size_t byteSize = 0;
+  auto buffer = videoDecoder->onCopyFrame(&byteSize);
+  if (buffer == nullptr) {
+    return;
+  }
+  seekCache[currentDecodedTime] = {std::move(buffer), byteSize};
+  seekCacheBytes += byteSize;
+  // Drops the frames farthest from the target first. Seeking backwards decodes from the previous
+  // keyframe up to the target, so the frames kept are the ones right before the target, which are
+  // exactly what reverse playback and scrubbing ask for next.
+  while (seekCacheBytes > maxBytes && !seekCache.empty()) {
+    auto first = seekCache.begin();
+    auto last = std::prev(seekCache.end());
+    auto farthest = targetTime - first->first >= last->first - targetTime ? first : last;
+    seekCacheBytes -= farthest->second.byteSize;
+    seekCache.erase(farthest);
+  }
+}
+
+void VideoReader::clearSeekCache() {
+  seekCache.clear();
+  seekCacheBytes = 0;
+}
+
 std::unique_ptr<VideoDecoder> VideoReader::makeVideoDecoder() {
   static const auto factories = Platform::Current()->getVideoDecoderFactories();
   while (factoryIndex < static_cast<int>(factories.size())) {
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <atomic>
+#include <map>
 #include "SequenceReader.h"
 #include "rendering/video/VideoDecoderFactory.h"
 #include "rendering/video/VideoDemuxer.h"
@@ -26,6 +27,11 @@
 namespace pag {
 class VideoReader : public SequenceReader {
  public:
+  struct CachedFrame {
+    std::shared_ptr<tgfx::ImageBuffer> buffer = nullptr;
+    size_t byteSize = 0;
+  };
+
   explicit VideoReader(std::unique_ptr<VideoDemuxer> demuxer);
 
   ~VideoReader() override;
@@ -38,6 +44,14 @@ class VideoReader : public SequenceReader {
     return demuxer->getFormat().height;
   }
 
+  size_t maxBufferCount() const override {
+    return bufferCount;
+  }
+
+  void enableBufferCopies() override {
+    copyFrames = true;
+  }
+
  protected:
   std::shared_ptr<tgfx::ImageBuffer> onMakeBuffer(Frame targetFrame) override;
 
@@ -58,6 +72,14 @@ class VideoReader : public SequenceReader {
   int64_t currentRenderedTime = INT64_MIN;
   std::atomic_int64_t hardDecodingInitialTime = 0;
   std::atomic_int64_t softDecodingInitialTime = 0;
+  std::atomic_bool copyFrames = false;
+  // Updated with the decoder, which is accessed by the decoding thread only.
+  std::atomic_size_t bufferCount = 1;
+  // The copies of the frames recently decoded on the way to the targets, keyed by their times.
+  std::map<int64_t, CachedFrame> seekCache = {};
+  size_t seekCacheBytes = 0;
+  // The smallest size a copied frame can take, the seek cache is disabled below it.
+  size_t frameBytes = 0;
 
   void destroyVideoDecoder();
 
@@ -70,5 +92,11 @@ class VideoReader : public SequenceReader {
   bool decodeFrame(int64_t sampleTime);
 
   std::unique_ptr<VideoDecoder> makeVideoDecoder();
+
+  std::shared_ptr<tgfx::ImageBuffer> getCachedFrame(int64_t sampleTime);
+
+  void cacheDecodedFrame(int64_t targetTime);
+
+  void clearSeekCache();
 };
 }  // namespace pag
@@ -23,6 +23,7 @@ namespace pag {
 VideoSequenceDemuxer::VideoSequenceDemuxer(std::shared_ptr<File> file, VideoSequence* sequence,
                                            PAGFile* pagFile)
     : sequence(sequence), file(std::move(file)), pagFile(pagFile) {
+  sequence->decodeDeferredFrames();
   format.width = sequence->getVideoWidth();
   format.height = sequence->getVideoHeight();
   for (auto& header : sequence->headers) {
@@ -54,6 +55,9 @@ VideoSample VideoSequenceDemuxer::nextSample() {
   }
   VideoSample sample = {};
   auto videoFrame = sequence->frames[sampleIndex];
+  if (videoFrame->fileBytes == nullptr) {
+    return {};
+  }
   sample.data = videoFrame->fileBytes->data();
   sample.length = videoFrame->fileBytes->length();
   sample.time = FrameToTime(videoFrame->frame, sequence->frameRate);
@@ -0,0 +1,90 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameBufferPool.h"
+#include <new>
+
+namespace pag {
+// The released buffers beyond this are freed immediately.
+static constexpr size_t MAX_FREE_BYTES = 64 * 1024 * 1024;
+// Each buffer starts with a header recording its size, which keeps the pixels 16-byte aligned.
+static constexpr size_t HEADER_SIZE = 16;
+
+FrameBufferPool* FrameBufferPool::Get() {
+  static auto& pool = *new FrameBufferPool();
+  return &pool;
+}
+
+std::shared_ptr<tgfx::Data> FrameBufferPool::makeData(size_t size) {
+  if (size == 0) {
+    return nullptr;
+  }
+  uint8_t* buffer = nullptr;
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto result = freeBuffers.find(size);
+    if (result != freeBuffers.end() && !result->second.empty()) {
+      buffer = result->second.back();
+      result->second.pop_back();
+      _freeBytes -= size;
+    }
+  }
+  if (buffer == nullptr) {
+    buffer = new (std::nothrow) uint8_t[size + HEADER_SIZE];
+    if (buffer == nullptr) {
+      return nullptr;
+    }
+    *reinterpret_cast<size_t*>(buffer) = size;
+  }
+  return tgfx::Data::MakeAdopted(buffer + HEADER_SIZE, size, ReleaseProc, this);
+}
+
+size_t FrameBufferPool::freeBytes() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  return _freeBytes;
+}
+
+void FrameBufferPool::purge() {
+  std::lock_guard<std::mutex> autoLock(locker);
+  for (auto& item : freeBuffers) {
+    for (auto buffer : item.second) {
+      delete[] buffer;
+    }
+  }
+  freeBuffers.clear();
+  _freeBytes = 0;
+}
+
+void FrameBufferPool::ReleaseProc(const void* data, void* context) {
+  auto buffer = const_cast<uint8_t*>(static_cast<const uint8_t*>(data)) - HEADER_SIZE;
+  static_cast<FrameBufferPool*>(context)->recycle(buffer);
+}
+
+void FrameBufferPool::recycle(uint8_t* buffer) {
+  auto size = *reinterpret_cast<size_t*>(buffer);
+  {
+    std::lock_guard<std::mutex> autoLock(locker);
+    if (_freeBytes + size <= MAX_FREE_BYTES) {
+      freeBuffers[size].push_back(buffer);
+      _freeBytes += size;
+      return;
+    }
+  }
+  delete[] buffer;
+}
+}  // namespace pag
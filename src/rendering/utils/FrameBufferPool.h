@@ -0,0 +1,64 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "tgfx/core/Data.h"
+
+namespace pag {
+/**
+ * FrameBufferPool recycles the pixel memory of the decoded frames. The memory of a Data created by
+ * the pool returns to the pool once the Data is released, and the next request of the same size
+ * reuses it, so the readers created and destroyed as the sequences come and go do not allocate new
+ * frame buffers in the steady state.
+ */
+class FrameBufferPool {
+ public:
+  /**
+   * Returns the FrameBufferPool shared by all decoders.
+   */
+  static FrameBufferPool* Get();
+
+  /**
+   * Returns a Data of the specified size. The contents of the memory are undefined if it is reused.
+   */
+  std::shared_ptr<tgfx::Data> makeData(size_t size);
+
+  /**
+   * Returns the memory in bytes of the released buffers kept for reuse.
+   */
+  size_t freeBytes();
+
+  /**
+   * Frees all the released buffers kept for reuse.
+   */
+  void purge();
+
+ private:
+  std::mutex locker = {};
+  std::unordered_map<size_t, std::vector<uint8_t*>> freeBuffers = {};
+  size_t _freeBytes = 0;
+
+  static void ReleaseProc(const void* data, void* context);
+
+  void recycle(uint8_t* buffer);
+};
+}  // namespace pag
@@ -20,37 +20,57 @@
 
 #ifdef PAG_USE_SYSTEM_LZ4
 #include <compression.h>
+#include <new>
 #else
 #include "lz4.h"
 #endif
 
 namespace pag {
 #ifdef PAG_USE_SYSTEM_LZ4
-class AppleLZ4Decoder : public LZ4Decoder {
- public:
-  AppleLZ4Decoder() {
-    auto scratchSize = compression_decode_scratch_buffer_size(COMPRESSION_LZ4);
-    if (scratchSize > 0) {
-      scratchBuffer = new (std::nothrow) uint8_t[scratchSize];
-    }
+/**
+ * Returns a scratch buffer owned by the calling thread, which lets the readers of the same sequence
+ * decode frames in parallel. The buffer only grows and is released when the thread exits.
+ */
+static uint8_t* GetScratchBuffer(size_t size) {
+  static thread_local std::unique_ptr<uint8_t[]> scratchBuffer = nullptr;
+  static thread_local size_t scratchSize = 0;
+  if (scratchSize < size) {
+    scratchBuffer.reset(new (std::nothrow) uint8_t[size]);
+    scratchSize = scratchBuffer != nullptr ? size : 0;
   }
+  return scratchBuffer.get();
+}
 
-  ~AppleLZ4Decoder() override {
-    delete[] scratchBuffer;
+class AppleLZ4Decoder : public LZ4Decoder {
+ public:
+  explicit AppleLZ4Decoder(compression_algorithm algorithm)
+      : algorithm(algorithm), scratchSize(compression_decode_scratch_buffer_size(algorithm)) {
   }
 
   size_t decode(uint8_t* dstBuffer, size_t dstSize, const uint8_t* srcBuffer,
                 size_t srcSize) const override {
+    uint8_t* scratchBuffer = nullptr;
+    if (scratchSize > 0) {
+      scratchBuffer = GetScratchBuffer(scratchSize);
+      if (scratchBuffer == nullptr) {
+        return 0;
+      }
+    }
     return compression_decode_buffer(dstBuffer, dstSize, srcBuffer, srcSize, scratchBuffer,
-                                     COMPRESSION_LZ4);
+                                     algorithm);
   }
 
  private:
-  uint8_t* scratchBuffer = nullptr;
+  compression_algorithm algorithm = COMPRESSION_LZ4;
+  size_t scratchSize = 0;
 };
 
 std::unique_ptr<LZ4Decoder> LZ4Decoder::Make() {
-  return std::make_unique<AppleLZ4Decoder>();
+  return std::make_unique<AppleLZ4Decoder>(COMPRESSION_LZ4);
+}
+
+std::unique_ptr<LZ4Decoder> LZ4Decoder::MakeRaw() {
+  return std::make_unique<AppleLZ4Decoder>(COMPRESSION_LZ4_RAW);
 }
 
 #else
@@ -69,5 +89,9 @@ std::unique_ptr<LZ4Decoder> LZ4Decoder::Make() {
   return std::make_unique<DefaultLZ4Decoder>();
 }
 
+std::unique_ptr<LZ4Decoder> LZ4Decoder::MakeRaw() {
+  return std::make_unique<DefaultLZ4Decoder>();
+}
+
 #endif
 }  // namespace pag
@@ -25,11 +25,17 @@ class LZ4Decoder {
  public:
   static std::unique_ptr<LZ4Decoder> Make();
 
+  /**
+   * Creates a decoder of the raw LZ4 block format, which is portable across all platforms.
+   */
+  static std::unique_ptr<LZ4Decoder> MakeRaw();
+
   virtual ~LZ4Decoder() = default;
 
   /**
    * Decompresses the contents of a source buffer into a destination buffer. Returns the number of
-   * bytes written to the destination buffer after decompressing the input.
+   * bytes written to the destination buffer after decompressing the input. It is safe to call
+   * from multiple threads at the same time.
    */
   virtual size_t decode(uint8_t* dstBuffer, size_t dstSize, const uint8_t* srcBuffer,
                         size_t srcSize) const = 0;
@@ -27,8 +27,8 @@ namespace pag {
 #ifdef PAG_USE_SYSTEM_LZ4
 class AppleLZ4Encoder : public LZ4Encoder {
  public:
-  AppleLZ4Encoder() {
-    auto scratchSize = compression_encode_scratch_buffer_size(COMPRESSION_LZ4);
+  explicit AppleLZ4Encoder(compression_algorithm algorithm) : algorithm(algorithm) {
+    auto scratchSize = compression_encode_scratch_buffer_size(algorithm);
     if (scratchSize > 0) {
       scratchBuffer = new (std::nothrow) uint8_t[scratchSize];
     }
@@ -41,15 +41,20 @@ class AppleLZ4Encoder : public LZ4Encoder {
   size_t encode(uint8_t* dstBuffer, size_t dstSize, const uint8_t* srcBuffer,
                 size_t srcSize) const override {
     return compression_encode_buffer(dstBuffer, dstSize, srcBuffer, srcSize, scratchBuffer,
-                                     COMPRESSION_LZ4);
+                                     algorithm);
   }
 
  private:
+  compression_algorithm algorithm = COMPRESSION_LZ4;
   uint8_t* scratchBuffer = nullptr;
 };
 
 std::unique_ptr<LZ4Encoder> LZ4Encoder::Make() {
-  return std::make_unique<AppleLZ4Encoder>();
+  return std::make_unique<AppleLZ4Encoder>(COMPRESSION_LZ4);
+}
+
+std::unique_ptr<LZ4Encoder> LZ4Encoder::MakeRaw() {
+  return std::make_unique<AppleLZ4Encoder>(COMPRESSION_LZ4_RAW);
 }
 
 size_t LZ4Encoder::GetMaxOutputSize(size_t inputSize) {
@@ -72,6 +77,10 @@ std::unique_ptr<LZ4Encoder> LZ4Encoder::Make() {
   return std::make_unique<DefaultLZ4Encoder>();
 }
 
+std::unique_ptr<LZ4Encoder> LZ4Encoder::MakeRaw() {
+  return std::make_unique<DefaultLZ4Encoder>();
+}
+
 size_t LZ4Encoder::GetMaxOutputSize(size_t inputSize) {
   return LZ4_compressBound(static_cast<int>(inputSize));
 }
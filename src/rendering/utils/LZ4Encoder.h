@@ -25,6 +25,11 @@ class LZ4Encoder {
  public:
   static std::unique_ptr<LZ4Encoder> Make();
 
+  /**
+   * Creates an encoder of the raw LZ4 block format, which is portable across all platforms.
+   */
+  static std::unique_ptr<LZ4Encoder> MakeRaw();
+
   /**
    * Provides the maximum size that LZ4 compression may output in a "worst case" scenario (input
    * data not compressible) This function is primarily useful for memory allocation purposes
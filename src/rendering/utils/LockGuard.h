@@ -20,18 +20,25 @@
 
 #include <memory>
 #include <mutex>
+#include "rendering/caches/CacheEpoch.h"
 
 namespace pag {
 
+/**
+ * Locks the root locker of a layer tree during its lifetime. It also keeps the current thread in
+ * the current CacheEpoch, since the layer caches shared with other layer trees may be accessed.
+ */
 class LockGuard {
  public:
   explicit LockGuard(std::shared_ptr<std::mutex> locker) : mutex(std::move(locker)) {
     if (mutex) {
       mutex->lock();
     }
+    epoch = CacheEpoch::Enter();
   }
 
   ~LockGuard() {
+    CacheEpoch::Exit(epoch);
     if (mutex) {
       mutex->unlock();
     }
@@ -39,6 +46,7 @@ class LockGuard {
 
  private:
   std::shared_ptr<std::mutex> mutex;
+  uint64_t epoch = 0;
 };
 
 }  // namespace pag
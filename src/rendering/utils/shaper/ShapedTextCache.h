@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Tencent is pleased to support the open source community by making libpag available.
+//
+//  Copyright (C) 2024 Tencent. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  unless required by applicable law or agreed to in writing, software distributed under the
+//  license is distributed on an "as is" basis, without warranties or conditions of any kind,
+//  either express or implied. see the license for the specific language governing permissions
+//  and limitations under the license.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "ShapedGlyph.h"
+
+namespace pag {
+// The texts replaced on many layers usually share a few strings and typefaces, so the shaped
+// results are kept for the recently used ones.
+static constexpr size_t MaxShapedTextCount = 512;
+
+struct ShapedTextKey {
+  uint32_t typefaceID = 0;
+  std::string text;
+
+  bool operator==(const ShapedTextKey& other) const {
+    return typefaceID == other.typefaceID && text == other.text;
+  }
+};
+
+struct ShapedTextHasher {
+  size_t operator()(const ShapedTextKey& key) const {
+    auto hash = std::hash<std::string>()(key.text);
+    return hash ^ (key.typefaceID + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+  }
+};
+
+/**
+ * ShapedTextCache keeps the shaped glyphs of the recently used texts in an LRU list.
+ */
+class ShapedTextCache {
+ public:
+  static ShapedTextCache* Get() {
+    static auto& cache = *new ShapedTextCache();
+    return &cache;
+  }
+
+  /**
+   * Copies the glyphs cached for the key into the given vector and marks them as the most recently
+   * used. Returns false if there is no cache for the key.
+   */
+  bool find(const ShapedTextKey& key, std::vector<ShapedGlyph>* glyphs) {
+    std::lock_guard<std::mutex> autoLock(locker);
+    auto result = entryMap.find(key);
+    if (result == entryMap.end()) {
+      return false;
+    }
+    entries.splice(entries.begin(), entries, result->second);
+    *glyphs = result->second->second;
+    return true;
+  }
+
+  /**
+   * Caches the glyphs for the key, the least recently used ones are dropped once there are more
+   * than MaxShapedTextCount texts.
+   */
+  void add(const ShapedTextKey& key, const std::vector<ShapedGlyph>& glyphs) {
+    std::lock_guard<std::mutex> autoLock(locker);
+    if (entryMap.find(key) != entryMap.end()) {
+      return;
+    }
+    entries.emplace_front(key, glyphs);
+    entryMap[key] = entries.begin();
+    while (entries.size() > MaxShapedTextCount) {
+      entryMap.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> autoLock(locker);
+    entryMap.clear();
+    entries.clear();
+  }
+
+ private:
+  using EntryList = std::list<std::pair<ShapedTextKey, std::vector<ShapedGlyph>>>;
+
+  std::mutex locker = {};
+  EntryList entries = {};
+  std::unordered_map<ShapedTextKey, EntryList::iterator, ShapedTextHasher> entryMap = {};
+};
+}  // namespace pag
@@ -17,6 +17,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "TextShaper.h"
+#include "ShapedTextCache.h"
 #ifdef PAG_USE_HARFBUZZ
 #include "TextShaperHarfbuzz.h"
 #else
@@ -25,11 +26,8 @@
 #endif
 
 namespace pag {
-std::vector<ShapedGlyph> TextShaper::Shape(const std::string& text,
-                                           std::shared_ptr<tgfx::Typeface> typeface) {
-  if (text.empty()) {
-    return {};
-  }
+static std::vector<ShapedGlyph> ShapeText(const std::string& text,
+                                          std::shared_ptr<tgfx::Typeface> typeface) {
 #ifdef PAG_USE_HARFBUZZ
   return TextShaperHarfbuzz::Shape(text, std::move(typeface));
 #else
@@ -43,7 +41,24 @@ std::vector<ShapedGlyph> TextShaper::Shape(const std::string& text,
 #endif
 }
 
+std::vector<ShapedGlyph> TextShaper::Shape(const std::string& text,
+                                           std::shared_ptr<tgfx::Typeface> typeface) {
+  if (text.empty()) {
+    return {};
+  }
+  ShapedTextKey key = {typeface ? typeface->uniqueID() : 0, text};
+  std::vector<ShapedGlyph> glyphs = {};
+  auto cache = ShapedTextCache::Get();
+  if (cache->find(key, &glyphs)) {
+    return glyphs;
+  }
+  glyphs = ShapeText(text, std::move(typeface));
+  cache->add(key, glyphs);
+  return glyphs;
+}
+
 void TextShaper::PurgeCaches() {
+  ShapedTextCache::Get()->clear();
 #ifdef PAG_USE_HARFBUZZ
   TextShaperHarfbuzz::PurgeCaches();
 #endif
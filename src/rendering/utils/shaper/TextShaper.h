@@ -28,7 +28,8 @@ namespace pag {
 class TextShaper {
  public:
   /**
-   * Shapes the given text using the specified typeface.
+   * Shapes the given text using the specified typeface. The results of the recently shaped texts
+   * are cached by the text and the typeface.
    */
   static std::vector<ShapedGlyph> Shape(const std::string& text,
                                         std::shared_ptr<tgfx::Typeface> typeface);
@@ -20,7 +20,7 @@
 
 #include "TextShaperHarfbuzz.h"
 #include <list>
-#include <map>
+#include <unordered_map>
 #include "base/utils/Log.h"
 #include "hb.h"
 #include "rendering/FontManager.h"
@@ -67,10 +67,12 @@ std::shared_ptr<hb_face_t> CreateHBFace(std::shared_ptr<tgfx::Typeface> typeface
   return hbFace;
 }
 
+using HBFontList = std::list<std::pair<uint32_t, std::shared_ptr<hb_font_t>>>;
+using HBFontMap = std::unordered_map<uint32_t, HBFontList::iterator>;
+
 class HBLockedFontCache {
  public:
-  HBLockedFontCache(std::list<uint32_t>* lru, std::map<uint32_t, std::shared_ptr<hb_font_t>>* cache,
-                    std::mutex* mutex)
+  HBLockedFontCache(HBFontList* lru, HBFontMap* cache, std::mutex* mutex)
       : lru(lru), cache(cache), mutex(mutex) {
     mutex->lock();
   }
@@ -83,27 +85,25 @@ class HBLockedFontCache {
   }
 
   std::shared_ptr<hb_font_t> find(uint32_t fontId) {
-    auto iter = std::find(lru->begin(), lru->end(), fontId);
-    if (iter == lru->end()) {
+    auto result = cache->find(fontId);
+    if (result == cache->end()) {
       return nullptr;
     }
-    lru->erase(iter);
-    lru->push_front(fontId);
-    return (*cache)[fontId];
+    lru->splice(lru->begin(), *lru, result->second);
+    return result->second->second;
   }
   std::shared_ptr<hb_font_t> insert(uint32_t fontId, std::shared_ptr<hb_font_t> hbFont) {
     if (hb_font_get_empty() == hbFont.get()) {
       return nullptr;
     }
-    static const int MaxCacheSize = 100;
-    cache->insert(std::make_pair(fontId, std::move(hbFont)));
-    lru->push_front(fontId);
+    static const size_t MaxCacheSize = 100;
+    lru->emplace_front(fontId, std::move(hbFont));
+    (*cache)[fontId] = lru->begin();
     while (lru->size() > MaxCacheSize) {
-      auto id = lru->back();
+      cache->erase(lru->back().first);
       lru->pop_back();
-      cache->erase(id);
     }
-    return (*cache)[fontId];
+    return lru->front().second;
   }
   void reset() {
     lru->clear();
@@ -111,15 +111,15 @@ class HBLockedFontCache {
   }
 
  private:
-  std::list<uint32_t>* lru;
-  std::map<uint32_t, std::shared_ptr<hb_font_t>>* cache;
+  HBFontList* lru;
+  HBFontMap* cache;
   std::mutex* mutex;
 };
 
 static HBLockedFontCache GetHBFontCache() {
   static auto* HBFontCacheMutex = new std::mutex();
-  static auto* HBFontLRU = new std::list<uint32_t>();
-  static auto* HBFontCache = new std::map<uint32_t, std::shared_ptr<hb_font_t>>();
+  static auto* HBFontLRU = new HBFontList();
+  static auto* HBFontCache = new HBFontMap();
   return {HBFontLRU, HBFontCache, HBFontCacheMutex};
 }
 
@@ -17,7 +17,10 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SoftAVCDecoder.h"
+#include <algorithm>
 #include <cstdlib>
+#include "VideoDecoderFactory.h"
+#include "rendering/utils/FrameBufferPool.h"
 #include "tgfx/core/Buffer.h"
 
 #ifdef PAG_USE_LIBAVC
@@ -34,6 +37,9 @@
 #endif
 
 namespace pag {
+// libavc decodes with at most 4 cores, see IH264_MAX_NUM_CORES in ih264d_defs.h.
+static constexpr int MAX_NUM_CORES = 4;
+
 #ifdef _WIN32
 static void* ivd_aligned_malloc(void*, WORD32 alignment, WORD32 size) {
   return _aligned_malloc(size, alignment);
@@ -88,9 +94,13 @@ bool SoftAVCDecoder::onConfigure(const std::vector<HeaderData>& headers, std::st
   return openDecoder();
 }
 
+SoftAVCDecoder::SoftAVCDecoder() {
+  VideoDecoderFactory::NotifySoftwareVideoDecoderCreated();
+}
+
 SoftAVCDecoder::~SoftAVCDecoder() {
   destroyDecoder();
-  delete outputFrame;
+  VideoDecoderFactory::NotifySoftwareVideoDecoderReleased();
 }
 
 DecoderResult SoftAVCDecoder::onSendBytes(void* bytes, size_t length, int64_t time) {
@@ -213,12 +223,16 @@ bool SoftAVCDecoder::initOutputFrame() {
   for (uint32_t i = 0; i < s_ctl_op.u4_min_num_out_bufs; i++) {
     outLength += s_ctl_op.u4_min_out_buf_size[i];
   }
-  outputFrame = new tgfx::Buffer(outLength);
+  outputFrame = FrameBufferPool::Get()->makeData(outLength);
+  if (outputFrame == nullptr) {
+    return false;
+  }
+  auto bytes = static_cast<uint8_t*>(const_cast<void*>(outputFrame->data()));
   auto& ps_out_buf = decodeInput.s_out_buffer;
   size_t offset = 0;
   for (uint32_t i = 0; i < s_ctl_op.u4_min_num_out_bufs; i++) {
     ps_out_buf.u4_min_out_buf_size[i] = s_ctl_op.u4_min_out_buf_size[i];
-    ps_out_buf.pu1_bufs[i] = outputFrame->bytes() + offset;
+    ps_out_buf.pu1_bufs[i] = bytes + offset;
     offset += s_ctl_op.u4_min_out_buf_size[i];
   }
   ps_out_buf.u4_num_bufs = s_ctl_op.u4_min_num_out_bufs;
@@ -279,7 +293,9 @@ bool SoftAVCDecoder::setNumCores() {
   ih264d_ctl_set_num_cores_op_t s_set_cores_op;
   s_set_cores_ip.e_cmd = IVD_CMD_VIDEO_CTL;
   s_set_cores_ip.e_sub_cmd = (IVD_CONTROL_API_COMMAND_TYPE_T)IH264D_CMD_CTL_SET_NUM_CORES;
-  s_set_cores_ip.u4_num_cores = 1;
+  // The thread budget is divided again each time the decoder is reopened after seeking.
+  auto numCores = std::min(VideoDecoderFactory::GetSoftwareDecoderThreadCount(), MAX_NUM_CORES);
+  s_set_cores_ip.u4_num_cores = static_cast<UWORD32>(numCores);
   s_set_cores_ip.u4_size = sizeof(ih264d_ctl_set_num_cores_ip_t);
   s_set_cores_op.u4_size = sizeof(ih264d_ctl_set_num_cores_op_t);
   auto status = ih264d_api_function(codecContext, &s_set_cores_ip, &s_set_cores_op);
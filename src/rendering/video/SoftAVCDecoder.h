@@ -43,6 +43,8 @@ namespace pag {
  */
 class SoftAVCDecoder : public SoftwareDecoder {
  public:
+  SoftAVCDecoder();
+
   ~SoftAVCDecoder() override;
 
   bool onConfigure(const std::vector<HeaderData>& headers, std::string mime, int width,
@@ -60,7 +62,9 @@ class SoftAVCDecoder : public SoftwareDecoder {
 
  private:
   std::shared_ptr<tgfx::Data> headerData = nullptr;
-  tgfx::Buffer* outputFrame = nullptr;
+  // The output memory comes from the FrameBufferPool, so the decoders created as the sequences
+  // come and go reuse it.
+  std::shared_ptr<tgfx::Data> outputFrame = nullptr;
   iv_obj_t* codecContext = nullptr;  // Codec context
   ivd_video_decode_ip_t decodeInput = {};
   ivd_video_decode_op_t decodeOutput = {};
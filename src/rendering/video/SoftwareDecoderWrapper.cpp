@@ -17,7 +17,9 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SoftwareDecoderWrapper.h"
+#include <cstring>
 #include "platform/Platform.h"
+#include "rendering/utils/FrameBufferPool.h"
 #include "rendering/video/SoftwareData.h"
 
 namespace pag {
@@ -84,10 +86,10 @@ DecodingResult SoftwareDecoderWrapper::onSendBytes(void* bytes, size_t length, i
       }
       uint32_t pos = 0;
       if (frameBuffer == nullptr) {
-        frameBuffer = new tgfx::Buffer(bytes, length);
-      } else {
-        frameBuffer->writeRange(0, length, bytes);
+        // Leaves room for the larger samples that follow, so the buffer is rarely reallocated.
+        frameBuffer = new tgfx::Buffer(length + length / 2);
       }
+      frameBuffer->writeRange(0, length, bytes);
       while (pos < length) {
         (*frameBuffer)[pos] = 0;
         (*frameBuffer)[pos + 1] = 0;
@@ -154,6 +156,37 @@ std::shared_ptr<tgfx::ImageBuffer> SoftwareDecoderWrapper::onRenderFrame() {
   return tgfx::ImageBuffer::MakeI420(std::move(yuvData), videoFormat.colorSpace);
 }
 
+std::shared_ptr<tgfx::ImageBuffer> SoftwareDecoderWrapper::onCopyFrame(size_t* byteSize) {
+  *byteSize = 0;
+  auto frame = softwareDecoder->onRenderFrame();
+  if (frame == nullptr) {
+    return nullptr;
+  }
+  size_t planeBytes[I420_PLANE_COUNT] = {};
+  size_t totalBytes = 0;
+  for (int i = 0; i < I420_PLANE_COUNT; i++) {
+    auto rows = i == 0 ? videoFormat.height : (videoFormat.height + 1) / 2;
+    planeBytes[i] = static_cast<size_t>(frame->lineSize[i]) * static_cast<size_t>(rows);
+    totalBytes += planeBytes[i];
+  }
+  auto pixels = FrameBufferPool::Get()->makeData(totalBytes);
+  if (pixels == nullptr) {
+    return nullptr;
+  }
+  auto address = static_cast<uint8_t*>(const_cast<void*>(pixels->data()));
+  uint8_t* planes[I420_PLANE_COUNT] = {};
+  for (int i = 0; i < I420_PLANE_COUNT; i++) {
+    memcpy(address, frame->data[i], planeBytes[i]);
+    planes[i] = address;
+    address += planeBytes[i];
+  }
+  *byteSize = totalBytes;
+  auto yuvData = SoftwareData<tgfx::Data>::Make(videoFormat.width, videoFormat.height, planes,
+                                                frame->lineSize, I420_PLANE_COUNT,
+                                                std::move(pixels));
+  return tgfx::ImageBuffer::MakeI420(std::move(yuvData), videoFormat.colorSpace);
+}
+
 int64_t SoftwareDecoderWrapper::presentationTime() {
   return currentDecodedTime;
 }
@@ -43,6 +43,12 @@ class SoftwareDecoderWrapper : public VideoDecoder {
 
   std::shared_ptr<tgfx::ImageBuffer> onRenderFrame() override;
 
+  std::shared_ptr<tgfx::ImageBuffer> onCopyFrame(size_t* byteSize) override;
+
+  bool canCopyFrames() const override {
+    return true;
+  }
+
   int64_t presentationTime() override;
 
  private:
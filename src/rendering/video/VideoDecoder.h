@@ -61,6 +61,23 @@ class VideoDecoder {
    */
   virtual std::shared_ptr<tgfx::ImageBuffer> onRenderFrame() = 0;
 
+  /**
+   * Returns a copy of the decoded video frame that stays valid after decoding the next frames, and
+   * stores the memory in bytes taken by the copy in byteSize. Returns nullptr if the decoder can
+   * not copy its frames, which is the default.
+   */
+  virtual std::shared_ptr<tgfx::ImageBuffer> onCopyFrame(size_t* byteSize) {
+    *byteSize = 0;
+    return nullptr;
+  }
+
+  /**
+   * Returns true if onCopyFrame() is supported by the decoder.
+   */
+  virtual bool canCopyFrames() const {
+    return false;
+  }
+
   /**
    * Returns current presentation time.
    */
@@ -17,7 +17,9 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "VideoDecoderFactory.h"
+#include <algorithm>
 #include <atomic>
+#include <thread>
 #include "SoftAVCDecoder.h"
 #include "SoftwareDecoderWrapper.h"
 #include "base/utils/USE.h"
@@ -32,6 +34,10 @@ static std::mutex factoryLocker = {};
 static SoftwareDecoderFactory* softwareDecoderFactory = {nullptr};
 static std::atomic_int maxHardwareDecoderCount = {65535};
 static std::atomic_int globalHardwareDecoderCount = {0};
+static std::atomic_int softwareDecoderThreadBudget = {0};
+static std::atomic_int maxSoftwareDecoderThreads = {1};
+static std::atomic_int globalSoftwareDecoderCount = {0};
+static std::atomic<size_t> maxSeekCacheBytes = {0};
 
 void PAGVideoDecoder::RegisterSoftwareDecoderFactory(SoftwareDecoderFactory* decoderFactory) {
   std::lock_guard<std::mutex> autoLock(factoryLocker);
@@ -42,6 +48,30 @@ void PAGVideoDecoder::SetMaxHardwareDecoderCount(int count) {
   maxHardwareDecoderCount = count;
 }
 
+int PAGVideoDecoder::SoftwareDecoderThreadBudget() {
+  return softwareDecoderThreadBudget;
+}
+
+void PAGVideoDecoder::SetSoftwareDecoderThreadBudget(int threadCount) {
+  softwareDecoderThreadBudget = std::max(threadCount, 0);
+}
+
+int PAGVideoDecoder::MaxSoftwareDecoderThreads() {
+  return maxSoftwareDecoderThreads;
+}
+
+void PAGVideoDecoder::SetMaxSoftwareDecoderThreads(int threadCount) {
+  maxSoftwareDecoderThreads = std::max(threadCount, 1);
+}
+
+size_t PAGVideoDecoder::MaxSeekCacheBytes() {
+  return maxSeekCacheBytes;
+}
+
+void PAGVideoDecoder::SetMaxSeekCacheBytes(size_t maxBytes) {
+  maxSeekCacheBytes = maxBytes;
+}
+
 static SoftwareDecoderFactory* GetSoftwareDecoderFactory() {
   if (softwareDecoderFactory) {
     return softwareDecoderFactory;
@@ -113,6 +143,27 @@ void VideoDecoderFactory::NotifyHardwareVideoDecoderReleased() {
   globalHardwareDecoderCount--;
 }
 
+void VideoDecoderFactory::NotifySoftwareVideoDecoderCreated() {
+  globalSoftwareDecoderCount++;
+}
+
+void VideoDecoderFactory::NotifySoftwareVideoDecoderReleased() {
+  globalSoftwareDecoderCount--;
+}
+
+int VideoDecoderFactory::GetSoftwareDecoderThreadCount() {
+  int maxThreads = maxSoftwareDecoderThreads;
+  if (maxThreads <= 1) {
+    return 1;
+  }
+  int budget = softwareDecoderThreadBudget;
+  if (budget <= 0) {
+    budget = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  auto decoderCount = std::max(static_cast<int>(globalSoftwareDecoderCount), 1);
+  return std::clamp(budget / decoderCount, 1, maxThreads);
+}
+
 std::unique_ptr<VideoDecoder> VideoDecoderFactory::createDecoder(const VideoFormat& format) const {
   auto hardwareBacked = isHardwareBacked();
   if (hardwareBacked && globalHardwareDecoderCount >= maxHardwareDecoderCount) {
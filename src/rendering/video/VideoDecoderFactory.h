@@ -67,6 +67,19 @@ class VideoDecoderFactory {
  private:
   static void NotifyHardwareVideoDecoderReleased();
 
+  /**
+   * Registers an active built-in software decoder to share the software decoding thread budget.
+   */
+  static void NotifySoftwareVideoDecoderCreated();
+
+  static void NotifySoftwareVideoDecoderReleased();
+
+  /**
+   * Returns the number of threads that each active built-in software decoder can use now.
+   */
+  static int GetSoftwareDecoderThreadCount();
+
   friend class VideoDecoder;
+  friend class SoftAVCDecoder;
 };
 }  // namespace pag
@@ -16,7 +16,11 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <mutex>
+#include <thread>
 #include "pag/pag.h"
 #include "platform/Platform.h"
 #include "rendering/caches/DiskCache.h"
@@ -101,9 +105,8 @@ PAG_TEST(PAGDiskCacheTest, SequenceFile) {
   EXPECT_EQ(sequenceFile->cachedFrames, 11);
   auto diskCache = sequenceFile->diskCache;
   EXPECT_FALSE(std::filesystem::exists(cacheDir + "/files/4.bin"));
-  EXPECT_TRUE(diskCache->openedFiles.size() == 1);
-  EXPECT_TRUE(diskCache->cachedFileInfos.size() == 2);
-  EXPECT_EQ(diskCache->cachedFiles.size(), 2u);
+  EXPECT_TRUE(diskCache->openedFileCount() == 1);
+  EXPECT_EQ(diskCache->cachedFileCount(), 2u);
   EXPECT_EQ(diskCache->fileIDCount, 4u);
   const auto InitialDiskSize = 568915u;
   EXPECT_EQ(diskCache->totalDiskSize, InitialDiskSize);
@@ -172,7 +175,7 @@ PAG_TEST(PAGDiskCacheTest, SequenceFile) {
   pixmap.reset(bitmap);
   buffer = BitmapBuffer::Wrap(pixmap.info(), pixmap.writablePixels());
 
-  const auto lastTotalDiskSize = diskCache->totalDiskSize;
+  const size_t lastTotalDiskSize = diskCache->totalDiskSize;
 
   PAGDiskCache::SetMaxDiskSize(1500000u);
   EXPECT_EQ(PAGDiskCache::MaxDiskSize(), 1500000u);
@@ -190,6 +193,7 @@ PAG_TEST(PAGDiskCacheTest, SequenceFile) {
   success = sequenceFile->readFrame(22, buffer);
   EXPECT_TRUE(success);
   EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/SequenceFile_22"));
+  diskCache->waitForEviction();
   EXPECT_EQ(diskCache->totalDiskSize,
             lastTotalDiskSize + sequenceFile->fileSize() - halfSequenceFileSize);
   EXPECT_FALSE(std::filesystem::exists(cacheDir + "/files/3.bin"));
@@ -343,6 +347,168 @@ PAG_TEST(PAGDiskCacheTest, PAGDecoder) {
   pag::PAGDiskCache::RemoveAll();
 }
 
+PAG_TEST(PAGDiskCacheTest, PAGDecoder_ReadFrames) {
+  pag::PAGDiskCache::RemoveAll();
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  pagFile = nullptr;
+  auto numFrames = decoder->numFrames();
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  std::mutex locker = {};
+  std::vector<int> readIndices = {};
+  auto success = decoder->readFrames(
+      0, numFrames, [&](int index, const void* pixels, size_t rowBytes) {
+        std::lock_guard<std::mutex> autoLock(locker);
+        readIndices.push_back(index);
+        if (index == 50) {
+          auto info = tgfx::ImageInfo::Make(bitmap.width(), bitmap.height(),
+                                            tgfx::ColorType::RGBA_8888,
+                                            tgfx::AlphaType::Premultiplied, rowBytes);
+          tgfx::Pixmap(bitmap).writePixels(info, pixels);
+        }
+      });
+  EXPECT_TRUE(success);
+  EXPECT_EQ(static_cast<int>(readIndices.size()), numFrames);
+  std::sort(readIndices.begin(), readIndices.end());
+  for (int i = 0; i < numFrames; i++) {
+    EXPECT_EQ(readIndices[i], i);
+  }
+  EXPECT_TRUE(Baseline::Compare(tgfx::Pixmap(bitmap), "PAGDiskCacheTest/decoder_frame_50"));
+  EXPECT_TRUE(decoder->sequenceFile->isComplete());
+  EXPECT_TRUE(decoder->reader == nullptr);
+  EXPECT_TRUE(decoder->getComposition() == nullptr);
+  success = decoder->readFrames(10, 5, [](int, const void*, size_t) {});
+  EXPECT_FALSE(success);
+  success = decoder->readFrames(0, numFrames + 1, [](int, const void*, size_t) {});
+  EXPECT_FALSE(success);
+  pag::PAGDiskCache::RemoveAll();
+}
+
+/**
+ * 用例描述: 多个线程同时无锁读取同一个 SequenceFile，读取结果与单线程读取一致
+ */
+PAG_TEST(PAGDiskCacheTest, SequenceFile_ConcurrentReads) {
+  pag::PAGDiskCache::RemoveAll();
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  pagFile = nullptr;
+  auto numFrames = decoder->numFrames();
+  auto success = decoder->readFrames(0, numFrames, [](int, const void*, size_t) {});
+  EXPECT_TRUE(success);
+  auto sequenceFile = decoder->sequenceFile;
+  ASSERT_TRUE(sequenceFile->isComplete());
+  auto info = sequenceFile->info();
+  std::vector<std::vector<uint8_t>> expectedFrames = {};
+  for (int index = 0; index < numFrames; index++) {
+    std::vector<uint8_t> pixels(info.byteSize());
+    ASSERT_TRUE(sequenceFile->readFrame(index, BitmapBuffer::Wrap(info, pixels.data())));
+    expectedFrames.push_back(std::move(pixels));
+  }
+
+  std::atomic<int> matchedCount = 0;
+  std::vector<std::thread> threads = {};
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&, i]() {
+      std::vector<uint8_t> pixels(info.byteSize());
+      auto buffer = BitmapBuffer::Wrap(info, pixels.data());
+      // Every thread starts at a different frame, so the reads of the same frame overlap less.
+      for (int count = 0; count < numFrames; count++) {
+        auto index = (count + i * numFrames / 4) % numFrames;
+        if (sequenceFile->readFrame(index, buffer) && pixels == expectedFrames[index]) {
+          matchedCount++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(matchedCount.load(), numFrames * 4);
+  pag::PAGDiskCache::RemoveAll();
+}
+
+PAG_TEST(PAGDiskCacheTest, UncompressedSequenceFile) {
+  pag::PAGDiskCache::RemoveAll();
+  EXPECT_TRUE(PAGDiskCache::CompressionEnabled());
+  PAGDiskCache::SetCompressionEnabled(false);
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  pagFile = nullptr;
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  auto success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  auto sequenceFile = decoder->sequenceFile;
+  ASSERT_TRUE(sequenceFile != nullptr);
+  EXPECT_TRUE(sequenceFile->compressionType == CompressionType::None);
+  EXPECT_TRUE(sequenceFile->mapFrame(50) == nullptr);
+  for (int i = 0; i < decoder->numFrames(); i++) {
+    success = decoder->readFrame(i, pixmap.writablePixels(), pixmap.rowBytes());
+    EXPECT_TRUE(success);
+  }
+  EXPECT_TRUE(sequenceFile->isComplete());
+  auto pixels = sequenceFile->mapFrame(50);
+  ASSERT_TRUE(pixels != nullptr);
+  EXPECT_TRUE(sequenceFile->mappedBytes != nullptr);
+  EXPECT_TRUE(
+      Baseline::Compare(tgfx::Pixmap(pixmap.info(), pixels), "PAGDiskCacheTest/decoder_frame_50"));
+  success = decoder->readFrame(50, pixmap.writablePixels(), pixmap.rowBytes());
+  EXPECT_TRUE(success);
+  EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/decoder_frame_50"));
+  PAGDiskCache::SetCompressionEnabled(true);
+  pag::PAGDiskCache::RemoveAll();
+}
+
+PAG_TEST(PAGDiskCacheTest, DeltaCompressedSequenceFile) {
+  pag::PAGDiskCache::RemoveAll();
+  EXPECT_FALSE(PAGDiskCache::DeltaCompressionEnabled());
+  PAGDiskCache::SetDeltaCompressionEnabled(true);
+  auto pagFile = LoadPAGFile("resources/apitest/data_bmp.pag");
+  ASSERT_TRUE(pagFile != nullptr);
+  auto decoder = PAGDecoder::MakeFrom(pagFile, 30, 0.5f);
+  ASSERT_TRUE(decoder != nullptr);
+  pagFile = nullptr;
+  tgfx::Bitmap bitmap(decoder->width(), decoder->height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  for (int i = 0; i < decoder->numFrames(); i++) {
+    auto success = decoder->readFrame(i, pixmap.writablePixels(), pixmap.rowBytes());
+    EXPECT_TRUE(success);
+  }
+  auto sequenceFile = decoder->sequenceFile;
+  ASSERT_TRUE(sequenceFile != nullptr);
+  EXPECT_TRUE(sequenceFile->compressionType == CompressionType::LZ4_DELTA);
+  EXPECT_TRUE(sequenceFile->isComplete());
+  EXPECT_TRUE(sequenceFile->referenceFrames.empty());
+  EXPECT_TRUE(sequenceFile->frames[0].keyframe);
+  int deltaFrames = 0;
+  for (int i = 0; i < decoder->numFrames(); i++) {
+    if (!sequenceFile->frames[i].keyframe) {
+      deltaFrames++;
+    }
+  }
+  EXPECT_GT(deltaFrames, 0);
+  auto buffer = BitmapBuffer::Wrap(pixmap.info(), pixmap.writablePixels());
+  auto success = sequenceFile->readFrame(50, buffer);
+  EXPECT_TRUE(success);
+  EXPECT_TRUE(Baseline::Compare(pixmap, "PAGDiskCacheTest/decoder_frame_50"));
+  // Reads from another thread, which has to decode the frame from the nearest keyframe.
+  std::thread([&]() {
+    tgfx::Bitmap threadBitmap(decoder->width(), decoder->height(), false, false);
+    tgfx::Pixmap threadPixmap(threadBitmap);
+    auto threadBuffer = BitmapBuffer::Wrap(threadPixmap.info(), threadPixmap.writablePixels());
+    EXPECT_TRUE(sequenceFile->readFrame(50, threadBuffer));
+    EXPECT_TRUE(Baseline::Compare(threadPixmap, "PAGDiskCacheTest/decoder_frame_50"));
+  }).join();
+  PAGDiskCache::SetDeltaCompressionEnabled(false);
+  pag::PAGDiskCache::RemoveAll();
+}
+
 PAG_TEST(PAGDiskCacheTest, PAGDecoder_StaticTimeRanges) {
   pag::PAGDiskCache::RemoveAll();
   auto pagFile = LoadPAGFile("resources/apitest/polygon.pag");
@@ -429,4 +595,151 @@ PAG_TEST(PAGDiskCacheTest, FileCache) {
   pag::PAGDiskCache::RemoveAll();
 }
 
+/**
+ * 用例描述: 分片后的磁盘缓存按全局访问顺序淘汰文件，并在后台任务中淘汰超出限制的文件
+ */
+PAG_TEST(PAGDiskCacheTest, ShardedEviction) {
+  auto cacheDir = Platform::Current()->getCacheDir() + "/eviction_test";
+  std::filesystem::remove_all(cacheDir);
+  // Larger than the sequence file below, so evicting one file is enough to make room for it.
+  std::vector<uint8_t> bytes(65536, 1);
+  auto data = tgfx::Data::MakeWithCopy(bytes.data(), bytes.size());
+  ASSERT_TRUE(data != nullptr);
+  auto diskCache = std::unique_ptr<DiskCache>(new DiskCache(cacheDir));
+  std::vector<std::string> keys = {};
+  std::vector<DiskCacheShard*> usedShards = {};
+  for (int i = 0; i < 8; i++) {
+    keys.push_back("key" + std::to_string(i));
+    EXPECT_TRUE(diskCache->writeFile(keys.back(), data));
+    usedShards.push_back(diskCache->getShard(keys.back()));
+  }
+  std::sort(usedShards.begin(), usedShards.end());
+  usedShards.erase(std::unique(usedShards.begin(), usedShards.end()), usedShards.end());
+  ASSERT_GT(usedShards.size(), 1u);
+  // Writing key0 again makes it the most recently used file.
+  EXPECT_TRUE(diskCache->writeFile(keys[0], data));
+  auto isCached = [&](const std::string& key) {
+    auto shard = diskCache->getShard(key);
+    std::lock_guard<std::mutex> autoLock(shard->locker);
+    auto result = shard->cachedFileIDs.find(key);
+    return result != shard->cachedFileIDs.end() &&
+           shard->cachedFileInfos.count(result->second) > 0;
+  };
+
+  // The least recently used files are evicted first, whichever shards they are in.
+  diskCache->setMaxDiskSize(data->size() * 6);
+  EXPECT_EQ(diskCache->totalDiskSize, data->size() * 6);
+  EXPECT_FALSE(isCached(keys[1]));
+  EXPECT_FALSE(isCached(keys[2]));
+  for (auto index : {0, 3, 4, 5, 6, 7}) {
+    EXPECT_TRUE(isCached(keys[index]));
+  }
+
+  // Growing an opened file over the limit evicts the oldest closed files on a background task.
+  auto info = tgfx::ImageInfo::Make(64, 64, tgfx::ColorType::RGBA_8888);
+  auto sequenceFile = diskCache->openSequence("sequence", info, 1, 30, {});
+  ASSERT_TRUE(sequenceFile != nullptr);
+  tgfx::Bitmap bitmap(info.width(), info.height(), false, false);
+  tgfx::Pixmap pixmap(bitmap);
+  auto pixels = static_cast<uint8_t*>(pixmap.writablePixels());
+  for (size_t i = 0; i < info.byteSize(); i++) {
+    pixels[i] = static_cast<uint8_t>(i * 7919 % 251);
+  }
+  EXPECT_TRUE(sequenceFile->writeFrame(0, BitmapBuffer::Wrap(pixmap.info(), pixels)));
+  diskCache->waitForEviction();
+  EXPECT_LE(diskCache->totalDiskSize, diskCache->maxDiskSize);
+  EXPECT_FALSE(isCached(keys[3]));
+  // The evicted files are always older than the ones left.
+  bool cached = false;
+  for (auto index : {3, 4, 5, 6, 7, 0}) {
+    if (isCached(keys[index])) {
+      cached = true;
+    } else {
+      EXPECT_FALSE(cached);
+    }
+  }
+  EXPECT_TRUE(isCached("sequence"));
+  sequenceFile = nullptr;
+  diskCache = nullptr;
+  std::filesystem::remove_all(cacheDir);
+}
+
+/**
+ * Waits until the background task has written all pending journal records or the new snapshot.
+ */
+static void WaitForConfigFlush(DiskCache* diskCache) {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> autoLock(diskCache->journalLocker);
+      if (!diskCache->flushScheduled) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::lock_guard<std::mutex> autoLock(diskCache->configLocker);
+}
+
+/**
+ * 用例描述: 重新打开磁盘缓存时回放 cache.journal，忽略被截断的记录，并在后台压缩为快照
+ */
+PAG_TEST(PAGDiskCacheTest, JournalReplay) {
+  auto cacheDir = Platform::Current()->getCacheDir() + "/journal_test";
+  std::filesystem::remove_all(cacheDir);
+  auto configPath = cacheDir + "/cache.cfg";
+  auto journalPath = cacheDir + "/cache.journal";
+  auto data = ReadFile("resources/apitest/polygon.pag");
+  ASSERT_TRUE(data != nullptr);
+
+  auto diskCache = std::unique_ptr<DiskCache>(new DiskCache(cacheDir));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(diskCache->writeFile("key" + std::to_string(i), data));
+  }
+  WaitForConfigFlush(diskCache.get());
+  EXPECT_FALSE(std::filesystem::exists(configPath));
+  ASSERT_TRUE(std::filesystem::exists(journalPath));
+  diskCache = nullptr;
+
+  // The records are replayed on reopening, then compacted into a snapshot in the background.
+  diskCache = std::unique_ptr<DiskCache>(new DiskCache(cacheDir));
+  EXPECT_EQ(diskCache->cachedFileCount(), 3u);
+  EXPECT_EQ(diskCache->totalDiskSize, data->size() * 3);
+  auto cacheData = diskCache->readFile("key1");
+  ASSERT_TRUE(cacheData != nullptr);
+  EXPECT_EQ(cacheData->size(), data->size());
+  WaitForConfigFlush(diskCache.get());
+  EXPECT_TRUE(std::filesystem::exists(configPath));
+  EXPECT_FALSE(std::filesystem::exists(journalPath));
+
+  // A record cut off in the middle is ignored, and so is the file it refers to.
+  EXPECT_TRUE(diskCache->writeFile("key3", data));
+  WaitForConfigFlush(diskCache.get());
+  ASSERT_TRUE(std::filesystem::exists(journalPath));
+  auto journalSize = std::filesystem::file_size(journalPath);
+  std::filesystem::resize_file(journalPath, journalSize - 2);
+  diskCache = nullptr;
+  diskCache = std::unique_ptr<DiskCache>(new DiskCache(cacheDir));
+  EXPECT_EQ(diskCache->cachedFileCount(), 3u);
+  EXPECT_TRUE(diskCache->readFile("key3") == nullptr);
+  EXPECT_TRUE(diskCache->readFile("key2") != nullptr);
+  WaitForConfigFlush(diskCache.get());
+
+  // The journal is compacted on the background task once it grows too large.
+  std::string longKey(1024, 'k');
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(diskCache->writeFile(longKey + std::to_string(i), data));
+  }
+  WaitForConfigFlush(diskCache.get());
+  EXPECT_TRUE(std::filesystem::exists(configPath));
+  if (std::filesystem::exists(journalPath)) {
+    EXPECT_LE(std::filesystem::file_size(journalPath), 64u * 1024u);
+  }
+  diskCache = nullptr;
+  diskCache = std::unique_ptr<DiskCache>(new DiskCache(cacheDir));
+  EXPECT_EQ(diskCache->cachedFileCount(), 103u);
+  EXPECT_TRUE(diskCache->readFile(longKey + "99") != nullptr);
+  WaitForConfigFlush(diskCache.get());
+  diskCache = nullptr;
+  std::filesystem::remove_all(cacheDir);
+}
 }  // namespace pag
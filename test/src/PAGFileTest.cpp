@@ -368,6 +368,190 @@ PAG_TEST(PAGFileLoadTest, loadTest) {
   ASSERT_TRUE(file == nullptr);
 }
 
+/**
+ * 用例描述: PAGFile内存映射解码测试
+ */
+PAG_TEST(PAGFileLoadTest, loadMappedTest) {
+  auto filePath = ProjectPath::Absolute("resources/apitest/complex_test.pag");
+  auto file = File::LoadMapped(filePath);
+  ASSERT_TRUE(file != nullptr);
+  auto encodeByteData = Codec::Encode(file);
+  auto verifyByteData = ByteData::FromPath(filePath);
+  ASSERT_EQ(verifyByteData->length(), encodeByteData->length());
+  ASSERT_EQ(memcmp(verifyByteData->data(), encodeByteData->data(), encodeByteData->length()), 0);
+
+  auto pagFile = PAGFile::LoadMapped(ProjectPath::Absolute("resources/apitest/test.pag"));
+  ASSERT_TRUE(pagFile != nullptr);
+  pagFile = PAGFile::LoadMapped(ProjectPath::Absolute("1.pag"));
+  ASSERT_TRUE(pagFile == nullptr);
+}
+
+/**
+ * 用例描述: PAGFile延迟解码测试
+ */
+PAG_TEST(PAGFileLoadTest, lazyDecodingTest) {
+  auto verifyByteData =
+      ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(verifyByteData != nullptr);
+  File::SetLazyDecodingEnabled(true);
+  auto file = File::Load(verifyByteData->data(), verifyByteData->length());
+  File::SetLazyDecodingEnabled(false);
+  ASSERT_TRUE(file != nullptr);
+  bool hasDeferredFrames = false;
+  for (auto composition : file->compositions) {
+    auto sequence = Sequence::Get(composition);
+    if (sequence != nullptr && sequence->hasDeferredFrames()) {
+      hasDeferredFrames = true;
+    }
+  }
+  ASSERT_TRUE(hasDeferredFrames);
+  auto encodeByteData = Codec::Encode(file);
+  ASSERT_EQ(verifyByteData->length(), encodeByteData->length());
+  ASSERT_EQ(memcmp(verifyByteData->data(), encodeByteData->data(), encodeByteData->length()), 0);
+  for (auto composition : file->compositions) {
+    auto sequence = Sequence::Get(composition);
+    if (sequence != nullptr) {
+      ASSERT_FALSE(sequence->hasDeferredFrames());
+    }
+  }
+}
+
+/**
+ * 用例描述: 延迟解码时位图序列帧在加载后仍未解码，静态区间与完整解码一致
+ */
+PAG_TEST(PAGFileLoadTest, lazyDecodingBitmapSequenceTest) {
+  auto byteData =
+      ByteData::FromPath(ProjectPath::Absolute("resources/apitest/bitmap_sequence_test.pag"));
+  ASSERT_TRUE(byteData != nullptr);
+  File::SetLazyDecodingEnabled(true);
+  auto file = File::Load(byteData->data(), byteData->length());
+  File::SetLazyDecodingEnabled(false);
+  ASSERT_TRUE(file != nullptr);
+  auto eagerFile = File::Load(byteData->data(), byteData->length());
+  ASSERT_TRUE(eagerFile != nullptr);
+  ASSERT_EQ(file->compositions.size(), eagerFile->compositions.size());
+  bool hasBitmapSequence = false;
+  for (size_t i = 0; i < file->compositions.size(); i++) {
+    auto composition = file->compositions[i];
+    if (composition->type() != CompositionType::Bitmap) {
+      continue;
+    }
+    hasBitmapSequence = true;
+    auto sequence = static_cast<BitmapComposition*>(composition)->sequences[0];
+    EXPECT_TRUE(sequence->hasDeferredFrames());
+    auto& staticTimeRanges = composition->staticTimeRanges;
+    auto& eagerTimeRanges = eagerFile->compositions[i]->staticTimeRanges;
+    ASSERT_EQ(staticTimeRanges.size(), eagerTimeRanges.size());
+    for (size_t j = 0; j < staticTimeRanges.size(); j++) {
+      EXPECT_EQ(staticTimeRanges[j].start, eagerTimeRanges[j].start);
+      EXPECT_EQ(staticTimeRanges[j].end, eagerTimeRanges[j].end);
+    }
+  }
+  ASSERT_TRUE(hasBitmapSequence);
+}
+
+/**
+ * 用例描述: PAGFile并行解码测试
+ */
+PAG_TEST(PAGFileLoadTest, parallelDecodingTest) {
+  auto verifyByteData =
+      ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(verifyByteData != nullptr);
+  File::SetParallelDecodingEnabled(true);
+  auto file = File::Load(verifyByteData->data(), verifyByteData->length());
+  File::SetParallelDecodingEnabled(false);
+  ASSERT_TRUE(file != nullptr);
+  auto serialFile = File::Load(verifyByteData->data(), verifyByteData->length());
+  ASSERT_TRUE(serialFile != nullptr);
+  ASSERT_EQ(file->tagLevel(), serialFile->tagLevel());
+  ASSERT_EQ(file->compositions.size(), serialFile->compositions.size());
+  auto encodeByteData = Codec::Encode(file);
+  ASSERT_EQ(verifyByteData->length(), encodeByteData->length());
+  ASSERT_EQ(memcmp(verifyByteData->data(), encodeByteData->data(), encodeByteData->length()), 0);
+}
+
+/**
+ * 用例描述: PAGFile关键帧烘焙测试
+ */
+PAG_TEST(PAGFileLoadTest, keyframeBakingTest) {
+  auto verifyByteData =
+      ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(verifyByteData != nullptr);
+  File::SetKeyframeBakingEnabled(true);
+  auto file = File::Load(verifyByteData->data(), verifyByteData->length());
+  File::SetKeyframeBakingEnabled(false);
+  ASSERT_TRUE(file != nullptr);
+  auto plainFile = File::Load(verifyByteData->data(), verifyByteData->length());
+  ASSERT_TRUE(plainFile != nullptr);
+  ASSERT_EQ(file->compositions.size(), plainFile->compositions.size());
+  bool hasBakedValues = false;
+  for (size_t i = 0; i < file->compositions.size(); i++) {
+    if (file->compositions[i]->type() != CompositionType::Vector) {
+      continue;
+    }
+    auto& layers = static_cast<VectorComposition*>(file->compositions[i])->layers;
+    auto& plainLayers = static_cast<VectorComposition*>(plainFile->compositions[i])->layers;
+    for (size_t j = 0; j < layers.size(); j++) {
+      auto transform = layers[j]->transform;
+      if (transform == nullptr || transform->position == nullptr ||
+          !transform->position->animatable()) {
+        continue;
+      }
+      auto position = static_cast<AnimatableProperty<Point>*>(transform->position);
+      auto plainPosition = plainLayers[j]->transform->position;
+      auto endTime = position->keyframes.back()->endTime;
+      // Seek backwards to skip the cached keyframe index.
+      for (Frame frame = endTime + 1; frame >= -1; frame--) {
+        ASSERT_TRUE(position->getValueAt(frame) == plainPosition->getValueAt(frame));
+      }
+      ASSERT_TRUE(position->bakedValues.load() != nullptr);
+      hasBakedValues = true;
+    }
+  }
+  ASSERT_TRUE(hasBakedValues);
+
+  // The paths are never baked, each frame would take a full copy of the path.
+  auto keyframe = new Keyframe<PathHandle>();
+  keyframe->startValue = keyframe->endValue = std::make_shared<PathData>();
+  keyframe->endTime = 10;
+  AnimatableProperty<PathHandle> pathProperty({keyframe});
+  pathProperty.setBakingEnabled(true);
+  EXPECT_FALSE(pathProperty.bakingEnabled);
+  pathProperty.getValueAt(5);
+  EXPECT_TRUE(pathProperty.bakedValues.load() == nullptr);
+}
+
+/**
+ * 用例描述: PAGFile压缩编解码测试
+ */
+PAG_TEST(PAGFileLoadTest, compressedBodyTest) {
+  auto verifyByteData =
+      ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(verifyByteData != nullptr);
+  auto file = File::Load(verifyByteData->data(), verifyByteData->length());
+  ASSERT_TRUE(file != nullptr);
+  auto compressedData = Codec::Encode(file, nullptr, BodyCompression::LZ4);
+  ASSERT_TRUE(compressedData != nullptr);
+  ASSERT_LT(compressedData->length(), verifyByteData->length());
+  auto compressedFile = File::Load(compressedData->data(), compressedData->length());
+  ASSERT_TRUE(compressedFile != nullptr);
+  auto encodeByteData = Codec::Encode(compressedFile);
+  ASSERT_EQ(verifyByteData->length(), encodeByteData->length());
+  ASSERT_EQ(memcmp(verifyByteData->data(), encodeByteData->data(), encodeByteData->length()), 0);
+
+  // truncated compressed data
+  compressedFile = File::Load(compressedData->data(), compressedData->length() - 20);
+  ASSERT_TRUE(compressedFile == nullptr);
+
+  // body length that the compressed data can never expand to
+  auto corruptedData = ByteData::Make(compressedData->length());
+  ASSERT_TRUE(corruptedData != nullptr);
+  memcpy(corruptedData->data(), compressedData->data(), compressedData->length());
+  memset(corruptedData->data() + 4, 0xFF, 4);
+  compressedFile = File::Load(corruptedData->data(), corruptedData->length());
+  ASSERT_TRUE(compressedFile == nullptr);
+}
+
 /**
  * 用例描述: PAGFile children编辑测试
  */
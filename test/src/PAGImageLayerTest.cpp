@@ -16,10 +16,13 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include "base/utils/Log.h"
 #include "nlohmann/json.hpp"
+#include "rendering/caches/ImageContentCache.h"
+#include "rendering/layers/PAGStage.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -50,6 +53,89 @@ PAG_TEST(PAGImageLayerTest, imageBasetTest) {
   EXPECT_TRUE(Baseline::Compare(TestPAGSurface, "PAGImageLayerTest/ImageReplacement_Empty"));
 }
 
+/**
+ * 用例描述: 不同文件中内容相同的图片共享同一份解码数据
+ */
+PAG_TEST(PAGImageLayerTest, sharedImageBytes) {
+  auto byteData = ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(byteData != nullptr);
+  auto file = File::Load(byteData->data(), byteData->length());
+  auto otherFile = File::Load(byteData->data(), byteData->length());
+  ASSERT_TRUE(file != nullptr && otherFile != nullptr);
+  ASSERT_FALSE(file->images.empty());
+  auto imageBytes = file->images[0];
+  auto otherImageBytes = otherFile->images[0];
+  ASSERT_NE(imageBytes, otherImageBytes);
+  // The scale factor is applied when drawing, so it does not prevent the image from being shared.
+  otherImageBytes->scaleFactor = imageBytes->scaleFactor * 0.5f;
+  auto graphic = ImageContentCache::GetGraphic(imageBytes);
+  auto otherGraphic = ImageContentCache::GetGraphic(otherImageBytes);
+  ASSERT_TRUE(graphic != nullptr && otherGraphic != nullptr);
+  auto sharedImage = static_cast<ImageBytesCache*>(imageBytes->cache)->sharedImage;
+  ASSERT_TRUE(sharedImage != nullptr);
+  EXPECT_EQ(sharedImage, static_cast<ImageBytesCache*>(otherImageBytes->cache)->sharedImage);
+  EXPECT_EQ(ImageContentCache::GetAssetID(imageBytes), sharedImage->uniqueID);
+  EXPECT_EQ(ImageContentCache::GetAssetID(otherImageBytes), sharedImage->uniqueID);
+  // The retained encoded bytes are reported in the shared memory budget.
+  EXPECT_GE(PAGMemoryCache::MemoryUsage(), sharedImage->data->size());
+
+  std::weak_ptr<SharedImage> weakImage = sharedImage;
+  sharedImage = nullptr;
+  graphic = nullptr;
+  otherGraphic = nullptr;
+  file = nullptr;
+  otherFile = nullptr;
+  // The image is still retained for the files loaded later until the unused images are purged.
+  EXPECT_FALSE(weakImage.expired());
+  PAGMemoryCache::PurgeUnusedImages();
+  EXPECT_TRUE(weakImage.expired());
+}
+
+/**
+ * 用例描述: 不同文件中内容相同的图片在同一个 PAGPlayer 中共享解码图片和快照缓存
+ */
+PAG_TEST(PAGImageLayerTest, sharedImageCaches) {
+  auto byteData = ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(byteData != nullptr);
+  auto pagFile = PAGFile::Load(byteData->data(), byteData->length());
+  auto otherPAGFile = PAGFile::Load(byteData->data(), byteData->length());
+  ASSERT_TRUE(pagFile != nullptr && otherPAGFile != nullptr);
+  ASSERT_NE(pagFile->getFile(), otherPAGFile->getFile());
+  auto imageBytes = pagFile->getFile()->images[0];
+  auto otherImageBytes = otherPAGFile->getFile()->images[0];
+  auto assetID = ImageContentCache::GetAssetID(imageBytes);
+  ASSERT_EQ(assetID, ImageContentCache::GetAssetID(otherImageBytes));
+
+  auto composition = PAGComposition::Make(pagFile->width(), pagFile->height());
+  composition->addLayer(pagFile);
+  composition->addLayer(otherPAGFile);
+  auto pagSurface = OffscreenSurface::Make(pagFile->width(), pagFile->height());
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(composition);
+  pagPlayer->flush();
+  // The image layers of both files are referenced by the same asset, so their scales are merged
+  // into one decoded image instead of one per file.
+  auto& referenceMap = pagPlayer->stage->layerReferenceMap;
+  ASSERT_EQ(referenceMap.count(assetID), 1u);
+  auto& layers = referenceMap[assetID];
+  auto fromFile = [](std::shared_ptr<File> file) {
+    return [file](PAGLayer* layer) { return layer->file == file; };
+  };
+  EXPECT_TRUE(std::any_of(layers.begin(), layers.end(), fromFile(pagFile->getFile())));
+  EXPECT_TRUE(std::any_of(layers.begin(), layers.end(), fromFile(otherPAGFile->getFile())));
+  EXPECT_EQ(referenceMap.count(imageBytes->uniqueID), 0u);
+  EXPECT_EQ(referenceMap.count(otherImageBytes->uniqueID), 0u);
+
+  composition->removeAllLayers();
+  pagPlayer->flush();
+  // The caches of the shared image are released once no layer uses it.
+  auto renderCache = pagPlayer->renderCache;
+  EXPECT_EQ(renderCache->assetImages.count(assetID), 0u);
+  EXPECT_EQ(renderCache->decodedAssetImages.count(assetID), 0u);
+  EXPECT_FALSE(renderCache->hasSnapshot(assetID));
+}
+
 /**
  * 用例描述: PAGImageLayer多线程替换测试
  */
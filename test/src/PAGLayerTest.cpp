@@ -17,7 +17,12 @@
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <base/utils/TimeUtil.h>
+#include <functional>
 #include "nlohmann/json.hpp"
+#include "rendering/caches/FrameCache.h"
+#include "rendering/caches/LayerCache.h"
+#include "rendering/caches/TransformCache.h"
+#include "rendering/renderers/TransformRenderer.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -304,4 +309,150 @@ PAG_TEST(PAGLayerTest, trackMatte_luma) {
   pagPlayer->flush();
   EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGLayerTest/trackMatte_luma"));
 }
+
+/**
+ * 用例描述: 限制每个图层缓存的帧数
+ */
+PAG_TEST(PAGLayerTest, maxFrameCacheCount) {
+  PAGMemoryCache::SetMaxFrameCacheCount(3);
+  EXPECT_EQ(PAGMemoryCache::MaxFrameCacheCount(), 3u);
+  auto pagFile = LoadPAGFile("resources/apitest/LumaTrackMatte.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto pagSurface = OffscreenSurface::Make(pagFile->width(), pagFile->height());
+  ASSERT_NE(pagSurface, nullptr);
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(pagFile);
+  auto evictedFrameCount = FrameCacheBudget::EvictedFrameCount();
+  for (int i = 0; i < 10; i++) {
+    pagPlayer->nextFrame();
+    pagPlayer->flush();
+  }
+  EXPECT_GT(FrameCacheBudget::EvictedFrameCount(), evictedFrameCount);
+  auto composition = static_cast<PreComposeLayer*>(pagFile->getLayer())->composition;
+  ASSERT_EQ(composition->type(), CompositionType::Vector);
+  for (auto layer : static_cast<VectorComposition*>(composition)->layers) {
+    auto layerCache = LayerCache::Get(layer);
+    EXPECT_LE(layerCache->transformCache->clockFrames.size(), 3u);
+    EXPECT_LE(layerCache->contentCache->clockFrames.size(), 3u);
+  }
+  pagPlayer->setProgress(0.5f);
+  pagPlayer->flush();
+  EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGLayerTest/trackMatte_luma"));
+  PAGMemoryCache::SetMaxFrameCacheCount(0);
+}
+
+class StaticFrameCache : public FrameCache<int> {
+ public:
+  explicit StaticFrameCache(Frame duration) : FrameCache<int>(0, duration) {
+  }
+
+ protected:
+  int* createCache(Frame layerFrame) override {
+    return new int(static_cast<int>(layerFrame));
+  }
+};
+
+static size_t CountFrameChunks(StaticFrameCache* frameCache) {
+  auto frameChunks = frameCache->chunks.load();
+  if (frameChunks == nullptr) {
+    return 0;
+  }
+  size_t count = 0;
+  for (size_t i = 0; i < frameCache->chunkCount(); i++) {
+    if (frameChunks[i].load() != nullptr) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * 用例描述: 帧缓存按需分块分配，静态的长图层只占用一个分块
+ */
+PAG_TEST(PAGLayerTest, frameCacheChunks) {
+  StaticFrameCache staticCache(36000);
+  EXPECT_EQ(CountFrameChunks(&staticCache), 0u);
+  auto cache = staticCache.getCache(35999);
+  ASSERT_NE(cache, nullptr);
+  EXPECT_EQ(*cache, 0);
+  EXPECT_EQ(staticCache.getCache(100), cache);
+  EXPECT_EQ(CountFrameChunks(&staticCache), 1u);
+
+  StaticFrameCache dynamicCache(36000);
+  dynamicCache.staticTimeRanges.clear();
+  EXPECT_EQ(*dynamicCache.getCache(100), 100);
+  EXPECT_EQ(*dynamicCache.getCache(101), 101);
+  EXPECT_EQ(*dynamicCache.getCache(35999), 35999);
+  EXPECT_EQ(CountFrameChunks(&dynamicCache), 2u);
+  EXPECT_EQ(dynamicCache.clockFrames.size(), 3u);
+}
+
+template <typename T>
+static Property<T>* MakeSteppedProperty(Frame duration, const std::function<T(Frame)>& valueAt) {
+  std::vector<Keyframe<T>*> keyframes = {};
+  for (Frame frame = 0; frame < duration; frame += 10) {
+    auto keyframe = new Keyframe<T>();
+    keyframe->startValue = keyframe->endValue = valueAt(frame);
+    keyframe->startTime = frame;
+    keyframe->endTime = frame + 10;
+    keyframes.push_back(keyframe);
+  }
+  return new AnimatableProperty<T>(keyframes);
+}
+
+static std::unique_ptr<Layer> MakeParentedLayer(Frame startTime, Frame duration, Layer* parent) {
+  auto layer = std::make_unique<NullLayer>();
+  layer->startTime = startTime;
+  layer->duration = duration;
+  layer->parent = parent;
+  layer->transform = Transform2D::MakeDefault().release();
+  return layer;
+}
+
+/**
+ * 用例描述: 图层变换复用父图层缓存的矩阵，父图层的起始时间各不相同时结果与逐级计算一致
+ */
+PAG_TEST(PAGLayerTest, parentTransformCache) {
+  auto grandparent = MakeParentedLayer(10, 60, nullptr);
+  delete grandparent->transform->rotation;
+  grandparent->transform->rotation =
+      MakeSteppedProperty<float>(100, [](Frame frame) { return static_cast<float>(frame); });
+  auto parent = MakeParentedLayer(30, 40, grandparent.get());
+  delete parent->transform->position;
+  parent->transform->position = MakeSteppedProperty<Point>(100, [](Frame frame) {
+    return Point::Make(static_cast<float>(frame), static_cast<float>(frame * 2));
+  });
+  auto layer = MakeParentedLayer(0, 120, parent.get());
+  delete layer->transform->scale;
+  layer->transform->scale = MakeSteppedProperty<Point>(120, [](Frame frame) {
+    auto scale = 1.0f + static_cast<float>(frame) / 100.0f;
+    return Point::Make(scale, scale);
+  });
+
+  auto transformCache = TransformCache::Get(layer.get());
+  for (Frame frame = 0; frame < layer->duration; frame++) {
+    auto layerFrame = frame + layer->startTime;
+    Transform expected = {};
+    RenderTransform(&expected, layer->transform, layerFrame);
+    for (auto ancestor = layer->parent; ancestor != nullptr; ancestor = ancestor->parent) {
+      Transform ancestorTransform = {};
+      RenderTransform(&ancestorTransform, ancestor->transform, layerFrame);
+      expected.matrix.postConcat(ancestorTransform.matrix);
+    }
+    // The parent matrices are concatenated in a different order, which may round differently.
+    float values[9] = {};
+    float expectedValues[9] = {};
+    transformCache->getCache(frame)->matrix.get9(values);
+    expected.matrix.get9(expectedValues);
+    for (int i = 0; i < 9; i++) {
+      EXPECT_NEAR(values[i], expectedValues[i], 1e-3f) << "frame " << frame;
+    }
+  }
+  // Only the transforms of the parents are cached, not their masks or contents.
+  EXPECT_TRUE(parent->transformCache != nullptr);
+  EXPECT_TRUE(parent->cache == nullptr);
+  EXPECT_TRUE(grandparent->cache == nullptr);
+  EXPECT_EQ(LayerCache::Get(layer.get())->transformCache, transformCache);
+}
 }  // namespace pag
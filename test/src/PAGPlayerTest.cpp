@@ -16,7 +16,9 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include "base/utils/TimeUtil.h"
 #include "nlohmann/json.hpp"
+#include "rendering/caches/MemoryCache.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -129,4 +131,90 @@ PAG_TEST(PAGPlayerTest, autoClear) {
   EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGPlayerTest/autoClear_autoClear_true"));
 }
 
-}  // namespace pag
\ No newline at end of file
+/**
+ * 用例描述: 多个PAGPlayer共享显存预算
+ */
+PAG_TEST(PAGPlayerTest, sharedMemoryBudget) {
+  auto defaultMaxMemorySize = PAGMemoryCache::MaxMemorySize();
+  auto pagFile = LoadPAGFile("resources/apitest/test.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto pagSurface = OffscreenSurface::Make(pagFile->width(), pagFile->height());
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(pagFile);
+  pagPlayer->flush();
+  auto pagFile2 = LoadPAGFile("resources/apitest/test.pag");
+  auto pagSurface2 = OffscreenSurface::Make(pagFile2->width(), pagFile2->height());
+  auto pagPlayer2 = std::make_shared<PAGPlayer>();
+  pagPlayer2->setSurface(pagSurface2);
+  pagPlayer2->setComposition(pagFile2);
+  pagPlayer2->flush();
+  auto memoryUsage = pagPlayer->renderCache->reportedMemory;
+  auto memoryUsage2 = pagPlayer2->renderCache->reportedMemory;
+  EXPECT_GT(memoryUsage, 0u);
+  EXPECT_GE(PAGMemoryCache::MemoryUsage(), memoryUsage + memoryUsage2);
+
+  PAGMemoryCache::SetMaxMemorySize(1);
+  EXPECT_EQ(PAGMemoryCache::MaxMemorySize(), 1u);
+  pagPlayer->flush();
+  pagPlayer2->flush();
+  EXPECT_TRUE(pagPlayer->renderCache->snapshotCaches.empty());
+  EXPECT_TRUE(pagPlayer2->renderCache->snapshotCaches.empty());
+  EXPECT_TRUE(pagPlayer->renderCache->decodedAssetImages.empty());
+  EXPECT_TRUE(pagPlayer2->renderCache->decodedAssetImages.empty());
+  EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGPlayerTest/sharedMemoryBudget"));
+
+  PAGMemoryCache::SetMaxMemorySize(defaultMaxMemorySize);
+  // The idle frame buffers in the total usage change as the players release their frames.
+  auto memoryCache = MemoryCache::GetInstance();
+  auto totalMemoryUsage = memoryCache->totalMemory.load();
+  memoryUsage2 = pagPlayer2->renderCache->reportedMemory;
+  pagPlayer2 = nullptr;
+  EXPECT_EQ(memoryCache->totalMemory.load(), totalMemoryUsage - memoryUsage2);
+}
+
+/**
+ * 用例描述: 并行准备可见图层与在绘制时串行构建图层的渲染结果一致
+ */
+PAG_TEST(PAGPlayerTest, parallelPrepare) {
+  auto byteData = ByteData::FromPath(ProjectPath::Absolute("resources/apitest/complex_test.pag"));
+  ASSERT_TRUE(byteData != nullptr);
+  // Loads the file twice without a path, so that the two players do not share any layer caches.
+  auto pagFile = PAGFile::Load(byteData->data(), byteData->length());
+  auto serialFile = PAGFile::Load(byteData->data(), byteData->length());
+  ASSERT_TRUE(pagFile != nullptr && serialFile != nullptr);
+  auto pagSurface = OffscreenSurface::Make(pagFile->width(), pagFile->height());
+  auto serialSurface = OffscreenSurface::Make(pagFile->width(), pagFile->height());
+  ASSERT_TRUE(pagSurface != nullptr && serialSurface != nullptr);
+  auto pagPlayer = std::make_unique<PAGPlayer>();
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(pagFile);
+  EXPECT_TRUE(pagPlayer->parallelPrepareEnabled());
+  auto serialPlayer = std::make_unique<PAGPlayer>();
+  serialPlayer->setSurface(serialSurface);
+  serialPlayer->setComposition(serialFile);
+  serialPlayer->setParallelPrepareEnabled(false);
+  EXPECT_FALSE(serialPlayer->parallelPrepareEnabled());
+
+  Bitmap bitmap(pagSurface->width(), pagSurface->height(), false, false);
+  Pixmap pixmap(bitmap);
+  Bitmap serialBitmap(serialSurface->width(), serialSurface->height(), false, false);
+  Pixmap serialPixmap(serialBitmap);
+  ASSERT_FALSE(pixmap.isEmpty() || serialPixmap.isEmpty());
+  auto totalFrames = TimeToFrame(pagFile->duration(), pagFile->frameRate());
+  for (Frame i = 0; i < totalFrames; i += 5) {
+    auto progress = static_cast<double>(i) / static_cast<double>(totalFrames);
+    pagPlayer->setProgress(progress);
+    serialPlayer->setProgress(progress);
+    ASSERT_TRUE(pagPlayer->flush());
+    ASSERT_TRUE(serialPlayer->flush());
+    ASSERT_TRUE(pagSurface->readPixels(ToPAG(pixmap.colorType()), ToPAG(pixmap.alphaType()),
+                                       pixmap.writablePixels(), pixmap.rowBytes()));
+    ASSERT_TRUE(serialSurface->readPixels(ToPAG(serialPixmap.colorType()),
+                                          ToPAG(serialPixmap.alphaType()),
+                                          serialPixmap.writablePixels(), serialPixmap.rowBytes()));
+    EXPECT_TRUE(memcmp(pixmap.pixels(), serialPixmap.pixels(), pixmap.byteSize()) == 0)
+        << "frame " << i;
+  }
+}
+}  // namespace pag
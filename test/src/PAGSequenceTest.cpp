@@ -16,10 +16,18 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include "base/utils/TimeUtil.h"
 #include "codec/mp4/MP4BoxHelper.h"
 #include "pag/pag.h"
 #include "platform/swiftshader/NativePlatform.h"
 #include "rendering/caches/RenderCache.h"
+#include "rendering/sequences/BitmapSequenceReader.h"
+#include "rendering/sequences/VideoReader.h"
+#include "rendering/sequences/VideoSequenceDemuxer.h"
+#include "rendering/utils/FrameBufferPool.h"
+#include "rendering/video/VideoDecoderFactory.h"
+#include "tgfx/core/ImageCodec.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -41,6 +49,81 @@ PAG_TEST(PAGSequenceTest, RenderOnScreen) {
   EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGSequenceTest/pagSequenceTest"));
 }
 
+/**
+ * 用例描述: 序列帧预解码多帧，并跟随播放方向预取
+ */
+PAG_TEST(PAGSequenceTest, PrefetchFrames) {
+  auto pagFile = LoadPAGFile("resources/apitest/wz_mvp.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto pagSurface = OffscreenSurface::Make(750, 1334);
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(pagFile);
+  pagPlayer->setMatrix(Matrix::I());
+  pagPlayer->setMaxPrefetchFrames(3);
+  EXPECT_EQ(pagPlayer->maxPrefetchFrames(), 3);
+  pagPlayer->setProgress(0.5);
+  pagPlayer->flush();
+  pagPlayer->nextFrame();
+  pagPlayer->flush();
+  auto& sequenceCaches = pagPlayer->renderCache->sequenceCaches;
+  ASSERT_EQ(static_cast<int>(sequenceCaches.size()), 1);
+  auto queue = sequenceCaches.begin()->second.front();
+  EXPECT_EQ(queue->queuedFrames.size(), 3u);
+  EXPECT_EQ(queue->direction, 1);
+  auto isQueued = [queue](Frame frame) {
+    queue->task->wait();
+    return std::any_of(queue->queuedFrames.begin(), queue->queuedFrames.end(),
+                       [frame](const QueuedFrame& item) { return item.frame == frame; });
+  };
+  EXPECT_TRUE(isQueued(queue->currentFrame + 1));
+  // Never queues more frames than the buffers the reader can hand out at the same time.
+  auto queuedCount = std::count_if(queue->queuedFrames.begin(), queue->queuedFrames.end(),
+                                   [](const QueuedFrame& item) { return item.frame >= 0; });
+  EXPECT_LE(static_cast<size_t>(queuedCount), queue->maxQueuedFrames());
+  EXPECT_EQ(isQueued(queue->currentFrame + 2), queue->maxQueuedFrames() > 1);
+  pagPlayer->preFrame();
+  pagPlayer->flush();
+  EXPECT_EQ(queue->direction, -1);
+  EXPECT_TRUE(isQueued(queue->currentFrame - 1));
+  EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGSequenceTest/pagSequenceTest"));
+
+  pagPlayer->setPrefetchMemoryLimit(1);
+  EXPECT_EQ(pagPlayer->prefetchMemoryLimit(), 1u);
+  pagPlayer->flush();
+  ASSERT_EQ(static_cast<int>(sequenceCaches.size()), 1);
+  EXPECT_EQ(sequenceCaches.begin()->second.front()->queuedFrames.size(), 1u);
+}
+
+/**
+ * 用例描述: 根据序列帧的解码耗时调整预解码的提前量
+ */
+PAG_TEST(PAGSequenceTest, PrefetchWindow) {
+  auto pagFile = LoadPAGFile("resources/apitest/wz_mvp.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto pagSurface = OffscreenSurface::Make(750, 1334);
+  auto pagPlayer = std::make_shared<PAGPlayer>();
+  pagPlayer->setSurface(pagSurface);
+  pagPlayer->setComposition(pagFile);
+  pagPlayer->setPrefetchWindow(1000000);
+  EXPECT_EQ(pagPlayer->prefetchWindow(), 1000000);
+  pagPlayer->setMaxConcurrentPrefetches(1);
+  EXPECT_EQ(pagPlayer->maxConcurrentPrefetches(), 1);
+  pagPlayer->setProgress(0.5);
+  pagPlayer->flush();
+  auto renderCache = pagPlayer->renderCache;
+  ASSERT_EQ(static_cast<int>(renderCache->sequenceCaches.size()), 1);
+  auto assetID = renderCache->sequenceCaches.begin()->first;
+  // A sequence never decoded starts at the beginning of the window.
+  EXPECT_EQ(renderCache->getPrefetchDistance(assetID, 1000000), 1000000);
+  renderCache->clearAllSequenceCaches();
+  ASSERT_EQ(renderCache->decodingCosts.count(assetID), 1u);
+  EXPECT_GT(renderCache->decodingCosts[assetID], 0);
+  auto distance = renderCache->getPrefetchDistance(assetID, 1000000);
+  EXPECT_GT(distance, 0);
+  EXPECT_LE(distance, 1000000);
+}
+
 /**
  * 用例描述: bitmapSequence关键帧不是全屏的时候要清屏
  */
@@ -57,6 +140,69 @@ PAG_TEST(PAGSequenceTest, BitmapSequenceReader) {
   EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGSequenceTest/BitmapSequenceReader"));
 }
 
+/**
+ * 用例描述: 位图序列帧随机 seek 的解码结果与顺序解码一致，包括比画布小的关键帧
+ */
+PAG_TEST(PAGSequenceTest, BitmapSequenceRandomSeek) {
+  auto byteData =
+      ByteData::FromPath(ProjectPath::Absolute("resources/apitest/bitmap_sequence_test.pag"));
+  ASSERT_TRUE(byteData != nullptr);
+  auto file = File::Load(byteData->data(), byteData->length());
+  ASSERT_TRUE(file != nullptr);
+  BitmapSequence* sequence = nullptr;
+  for (auto composition : file->compositions) {
+    if (composition->type() == CompositionType::Bitmap) {
+      sequence = static_cast<BitmapComposition*>(composition)->sequences.back();
+      break;
+    }
+  }
+  ASSERT_TRUE(sequence != nullptr);
+  sequence->decodeDeferredFrames();
+  // Turns a frame that only updates part of the canvas into a key frame.
+  bool hasSmallKeyframe = false;
+  for (size_t i = 1; i < sequence->frames.size() && !hasSmallKeyframe; i++) {
+    auto frame = sequence->frames[i];
+    if (frame->isKeyframe || frame->bitmaps.empty()) {
+      continue;
+    }
+    auto bytes = frame->bitmaps[0]->fileBytes;
+    auto codec = tgfx::ImageCodec::MakeFrom(
+        tgfx::Data::MakeWithoutCopy(bytes->data(), bytes->length()));
+    if (codec != nullptr &&
+        (codec->width() < sequence->width || codec->height() < sequence->height)) {
+      frame->isKeyframe = true;
+      hasSmallKeyframe = true;
+    }
+  }
+  ASSERT_TRUE(hasSmallKeyframe);
+
+  auto frameCount = static_cast<Frame>(sequence->frames.size());
+  auto sequentialReader = std::make_shared<BitmapSequenceReader>(file, sequence);
+  ASSERT_TRUE(sequentialReader->pixels != nullptr);
+  auto byteSize = sequentialReader->info.byteSize();
+  std::vector<std::vector<uint8_t>> expectedFrames = {};
+  for (Frame frame = 0; frame < frameCount; frame++) {
+    ASSERT_TRUE(sequentialReader->readBuffer(frame) != nullptr);
+    auto pixels = sequentialReader->pixels->bytes();
+    expectedFrames.emplace_back(pixels, pixels + byteSize);
+  }
+
+  auto randomReader = std::make_shared<BitmapSequenceReader>(file, sequence);
+  ASSERT_TRUE(randomReader->pixels != nullptr);
+  std::vector<Frame> frames = {};
+  for (Frame frame = 0; frame < frameCount; frame++) {
+    frames.push_back((frame * 7 + 3) % frameCount);
+  }
+  for (Frame frame = frameCount - 1; frame >= 0; frame--) {
+    frames.push_back(frame);
+  }
+  for (auto frame : frames) {
+    ASSERT_TRUE(randomReader->readBuffer(frame) != nullptr);
+    auto pixels = randomReader->pixels->bytes();
+    EXPECT_TRUE(memcmp(pixels, expectedFrames[frame].data(), byteSize) == 0) << "frame " << frame;
+  }
+}
+
 /**
  * 用例描述: 视频序列帧作为遮罩
  */
@@ -151,4 +297,99 @@ PAG_TEST(PAGSequenceTest, Sequence_Multiple_References) {
   EXPECT_EQ(static_cast<int>(sequenceCaches.begin()->second.size()), 1);
 }
 
+/**
+ * 用例描述: 序列帧像素内存的复用
+ */
+PAG_TEST(PAGSequenceTest, FrameBufferPool) {
+  auto pool = FrameBufferPool::Get();
+  pool->purge();
+  auto data = pool->makeData(1024);
+  ASSERT_TRUE(data != nullptr);
+  EXPECT_EQ(data->size(), 1024u);
+  auto bytes = data->data();
+  data = nullptr;
+  EXPECT_EQ(pool->freeBytes(), 1024u);
+  data = pool->makeData(1024);
+  EXPECT_EQ(data->data(), bytes);
+  EXPECT_EQ(pool->freeBytes(), 0u);
+  auto otherData = pool->makeData(2048);
+  EXPECT_NE(otherData->data(), bytes);
+  data = nullptr;
+  otherData = nullptr;
+  EXPECT_EQ(pool->freeBytes(), 3072u);
+  // The idle buffers are counted in the memory budget and released when the caches are freed.
+  EXPECT_GE(PAGMemoryCache::MemoryUsage(), 3072u);
+  auto pagSurface = OffscreenSurface::Make(100, 100);
+  ASSERT_TRUE(pagSurface != nullptr);
+  pagSurface->freeCache();
+  EXPECT_EQ(pool->freeBytes(), 0u);
+}
+
+/**
+ * 用例描述: 软解线程预算在活跃的软件解码器之间平均分配
+ */
+PAG_TEST(PAGSequenceTest, SoftwareDecoderThreadBudget) {
+  auto oldBudget = PAGVideoDecoder::SoftwareDecoderThreadBudget();
+  auto oldMaxThreads = PAGVideoDecoder::MaxSoftwareDecoderThreads();
+  EXPECT_EQ(VideoDecoderFactory::GetSoftwareDecoderThreadCount(), 1);
+  PAGVideoDecoder::SetSoftwareDecoderThreadBudget(8);
+  PAGVideoDecoder::SetMaxSoftwareDecoderThreads(4);
+  VideoDecoderFactory::NotifySoftwareVideoDecoderCreated();
+  EXPECT_EQ(VideoDecoderFactory::GetSoftwareDecoderThreadCount(), 4);
+  for (int i = 1; i < 4; i++) {
+    VideoDecoderFactory::NotifySoftwareVideoDecoderCreated();
+  }
+  EXPECT_EQ(VideoDecoderFactory::GetSoftwareDecoderThreadCount(), 2);
+  for (int i = 0; i < 4; i++) {
+    VideoDecoderFactory::NotifySoftwareVideoDecoderReleased();
+  }
+  PAGVideoDecoder::SetMaxSoftwareDecoderThreads(0);
+  EXPECT_EQ(PAGVideoDecoder::MaxSoftwareDecoderThreads(), 1);
+  PAGVideoDecoder::SetSoftwareDecoderThreadBudget(oldBudget);
+  PAGVideoDecoder::SetMaxSoftwareDecoderThreads(oldMaxThreads);
+}
+
+/**
+ * 用例描述: 视频序列帧向后 seek 时从 seek 缓存中读取已解码的帧
+ */
+PAG_TEST(PAGSequenceTest, VideoSeekCache) {
+  auto pagFile = LoadPAGFile("resources/apitest/video_sequence_with_mp4header.pag");
+  ASSERT_NE(pagFile, nullptr);
+  auto preComposeLayer = static_cast<const PreComposeLayer*>(pagFile->getLayer());
+  auto videoComposition = static_cast<VideoComposition*>(preComposeLayer->composition);
+  ASSERT_FALSE(videoComposition->sequences.empty());
+  auto videoSequence = videoComposition->sequences.at(0);
+  auto oldMaxBytes = PAGVideoDecoder::MaxSeekCacheBytes();
+  PAGVideoDecoder::SetMaxSeekCacheBytes(0);
+  auto demuxer = std::make_unique<VideoSequenceDemuxer>(pagFile->getFile(), videoSequence);
+  auto reader = std::make_shared<VideoReader>(std::move(demuxer));
+  ASSERT_NE(reader->readBuffer(10), nullptr);
+  EXPECT_TRUE(reader->seekCache.empty());
+
+  PAGVideoDecoder::SetMaxSeekCacheBytes(reader->frameBytes * 4);
+  ASSERT_NE(reader->readBuffer(5), nullptr);
+  ASSERT_NE(reader->videoDecoder, nullptr);
+  if (!reader->videoDecoder->isHardwareBacked()) {
+    EXPECT_LE(reader->seekCache.size(), 4u);
+    EXPECT_LE(reader->seekCacheBytes, reader->frameBytes * 4);
+    size_t cachedBytes = 0;
+    for (auto& item : reader->seekCache) {
+      EXPECT_GE(item.second.byteSize, reader->frameBytes);
+      cachedBytes += item.second.byteSize;
+    }
+    EXPECT_EQ(reader->seekCacheBytes, cachedBytes);
+    auto frameTime = FrameToTime(5, videoSequence->frameRate);
+    ASSERT_EQ(reader->seekCache.count(frameTime), 1u);
+    EXPECT_EQ(reader->lastBuffer, reader->seekCache[frameTime].buffer);
+    // Seeking forward and backward again is served from the cache without decoding.
+    reader->readBuffer(6);
+    auto decodedTime = reader->currentDecodedTime;
+    EXPECT_EQ(reader->readBuffer(5), reader->seekCache[frameTime].buffer);
+    EXPECT_EQ(reader->currentDecodedTime, decodedTime);
+  }
+  PAGVideoDecoder::SetMaxSeekCacheBytes(0);
+  reader->readBuffer(6);
+  EXPECT_TRUE(reader->seekCache.empty());
+  PAGVideoDecoder::SetMaxSeekCacheBytes(oldMaxBytes);
+}
 }  // namespace pag
@@ -16,6 +16,8 @@
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include "base/utils/BezierCache.h"
+#include "base/utils/BezierPath.h"
 #include "nlohmann/json.hpp"
 #include "utils/TestUtils.h"
 
@@ -36,4 +38,29 @@ PAG_TEST(PAGSimplePathTest, TestRect) {
   pagPlayer->flush();
   EXPECT_TRUE(Baseline::Compare(pagSurface, "PAGSimplePathTest/TestRect"));
 }
+
+/**
+ * 用例描述: 测试 BezierPath 缓存的命中统计和容量上限
+ */
+PAG_TEST(PAGSimplePathTest, BezierPathCache) {
+  auto hitCount = BezierPath::CacheHitCount();
+  auto missCount = BezierPath::CacheMissCount();
+  auto path = BezierPath::Build({0, 0}, {10, 40}, {30, 40}, {40, 0}, 0.05f);
+  auto cachedPath = BezierPath::Build({0, 0}, {10, 40}, {30, 40}, {40, 0}, 0.05f);
+  EXPECT_EQ(path, cachedPath);
+  EXPECT_GE(BezierPath::CacheHitCount(), hitCount + 1);
+  EXPECT_GE(BezierPath::CacheMissCount(), missCount + 1);
+
+  BezierCache<BezierKey, BezierPath, BezierHasher> cache = {};
+  for (int i = 0; i < 10000; i++) {
+    auto y = static_cast<float>(i);
+    Point points[] = {{0, y}, {10, y + 40}, {30, y + 40}, {40, y}};
+    auto key = BezierKey::Make(points, 0.05f);
+    EXPECT_EQ(cache.add(key, path), path);
+    EXPECT_EQ(cache.find(key), path);
+  }
+  EXPECT_EQ(cache.hitCount(), 10000u);
+  EXPECT_EQ(cache.missCount(), 0u);
+  EXPECT_LE(cache.size(), cache.ShardCount * cache.MaxShardSize);
+}
 }  // namespace pag
@@ -23,6 +23,8 @@
 #include "nlohmann/json.hpp"
 #include "pag/file.h"
 #include "rendering/renderers/TextRenderer.h"
+#include "rendering/utils/shaper/ShapedTextCache.h"
+#include "rendering/utils/shaper/TextShaper.h"
 #include "utils/TestUtils.h"
 
 namespace pag {
@@ -539,4 +541,39 @@ PAG_TEST(PAGTextLayerTest, TextLayerScaleAnimationWithMipmap) {
   EXPECT_TRUE(
       Baseline::Compare(TestPAGSurface, "PAGTextLayerTest/TextLayerScaleAnimationWithMipmap"));
 }
+
+/**
+ * 用例描述: 相同文本和字体的排版结果复用缓存
+ */
+PAG_TEST(PAGTextLayerTest, ShapedTextCache) {
+  auto typeface =
+      tgfx::Typeface::MakeFromPath(ProjectPath::Absolute("resources/font/NotoSansSC-Regular.otf"));
+  ASSERT_TRUE(typeface != nullptr);
+  std::string text = "PAG 动态字幕";
+  auto textCache = ShapedTextCache::Get();
+  ShapedTextKey key = {typeface->uniqueID(), text};
+  TextShaper::PurgeCaches();
+  std::vector<ShapedGlyph> foundGlyphs = {};
+  EXPECT_FALSE(textCache->find(key, &foundGlyphs));
+  auto glyphs = TextShaper::Shape(text, typeface);
+  ASSERT_FALSE(glyphs.empty());
+  EXPECT_EQ(textCache->entries.size(), 1u);
+  EXPECT_EQ(textCache->entryMap.count(key), 1u);
+  ASSERT_TRUE(textCache->find(key, &foundGlyphs));
+  EXPECT_EQ(foundGlyphs.size(), glyphs.size());
+  auto cachedGlyphs = TextShaper::Shape(text, typeface);
+  EXPECT_EQ(textCache->entries.size(), 1u);
+  TextShaper::PurgeCaches();
+  EXPECT_TRUE(textCache->entries.empty());
+  EXPECT_FALSE(textCache->find(key, &foundGlyphs));
+  auto shapedGlyphs = TextShaper::Shape(text, typeface);
+  EXPECT_TRUE(textCache->find(key, &foundGlyphs));
+  ASSERT_EQ(glyphs.size(), cachedGlyphs.size());
+  ASSERT_EQ(glyphs.size(), shapedGlyphs.size());
+  for (size_t i = 0; i < glyphs.size(); i++) {
+    EXPECT_EQ(glyphs[i].glyphIDs, cachedGlyphs[i].glyphIDs);
+    EXPECT_EQ(glyphs[i].stringIndex, cachedGlyphs[i].stringIndex);
+    EXPECT_EQ(glyphs[i].glyphIDs, shapedGlyphs[i].glyphIDs);
+  }
+}
 }  // namespace pag